@@ -0,0 +1,196 @@
+#include "libgb/cartridge.hpp"
+#include "libgb/error_handling.hpp"
+#include "libgb/gb.hpp"
+#include "libgb/io/capture.hpp"
+#include "libgb/io/headless.hpp"
+#include "libgb/utils/checked_int.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every workload runs a fixed number of frames from power on, so results are
+// comparable between commits.
+struct Scenario {
+  const char* name;
+  const char* rom;
+  uint64_t frames;
+  bool capture;  // Draw every frame and stream it to /dev/null
+};
+
+std::array<Scenario, 3> scenarios = {{
+    // CPU-bound, nothing is drawn
+    {"cpu_instrs", "tests/cpu_instrs/cpu_instrs.gb", 1200, false},
+    // Every frame is drawn and written by the capture frontend
+    {"render_capture", "tests/cpu_instrs/cpu_instrs.gb", 600, true},
+    // All four sound channels are busy
+    {"dmg_sound", "tests/dmg_sound/dmg_sound.gb", 1200, false},
+}};
+
+struct Sample {
+  double seconds;
+  uint64_t cycles;
+  uint64_t frames;
+  uint64_t instructions;
+};
+
+auto runScenario(const Scenario& scenario) -> Sample {
+  /*
+  Times a single run from a freshly loaded ROM. Loading isn't timed.
+  */
+  using namespace std::chrono;
+
+  std::stringstream serialOut;
+  std::unique_ptr<gb::IOFrontend> frontend =
+      std::make_unique<gb::Headless>(serialOut);
+  gb::CaptureFrontend* capture = nullptr;
+  if (scenario.capture) {
+    auto captureFrontend = std::make_unique<gb::CaptureFrontend>(
+        std::move(frontend),
+        gb::CaptureOptions{.format = gb::CaptureFormat::raw,
+                           .path = "/dev/null"});
+    capture = captureFrontend.get();
+    frontend = std::move(captureFrontend);
+  }
+  // No save file, battery RAM mustn't carry over between runs
+  gb::GB gameboy(gb::Cartridge::loadFromRom(scenario.rom), std::move(frontend));
+
+  const auto start = steady_clock::now();
+  gameboy.runFrames(scenario.frames);
+  if (capture != nullptr) {
+    capture->flush();  // Queued frames are part of the work
+  }
+  const auto end = steady_clock::now();
+
+  return {
+      .seconds = duration<double>(end - start).count(),
+      .cycles = gameboy.io.cycle,
+      .frames = gameboy.io.frameCount(),
+      .instructions = gameboy.cpu.instructionCount(),
+  };
+}
+
+auto printSample(std::ostream& out, const Sample& sample) -> void {
+  // Emulated clock in MHz, real hardware runs at 4.194304MHz
+  const double instructions = (double)sample.instructions;
+  out << "{\"seconds\": " << sample.seconds
+      << ", \"emulated_mhz\": "
+      << 4.0 * (double)sample.cycles / sample.seconds / 1e6
+      << ", \"frames_per_second\": "
+      << (double)sample.frames / sample.seconds
+      << ", \"instructions_per_second\": " << instructions / sample.seconds
+      << ", \"ns_per_instruction\": " << sample.seconds * 1e9 / instructions
+      << "}";
+}
+
+auto printScenario(std::ostream& out,
+                   const Scenario& scenario,
+                   size_t warmup,
+                   size_t repetitions) -> void {
+  /*
+  Runs the warmup repetitions untimed, then reports every timed repetition
+  and the median one. All repetitions do the same work.
+  */
+  for (size_t i = 0; i < warmup; i++) {
+    runScenario(scenario);
+  }
+
+  std::vector<Sample> samples;
+  for (size_t i = 0; i < repetitions; i++) {
+    samples.push_back(runScenario(scenario));
+    std::cerr << scenario.name << ": " << samples.back().seconds << "s"
+              << std::endl;
+  }
+
+  std::vector<Sample> sorted = samples;
+  std::ranges::sort(sorted, {}, &Sample::seconds);
+  const Sample& median = sorted[sorted.size() / 2];
+
+  out << "    {\n      \"name\": \"" << scenario.name << "\",\n"
+      << "      \"rom\": \"" << scenario.rom << "\",\n"
+      << "      \"cycles\": " << median.cycles << ",\n"
+      << "      \"frames\": " << median.frames << ",\n"
+      << "      \"instructions\": " << median.instructions << ",\n"
+      << "      \"median\": ";
+  printSample(out, median);
+  out << ",\n      \"repetitions\": [";
+  for (size_t i = 0; i < samples.size(); i++) {
+    out << (i == 0 ? "\n        " : ",\n        ");
+    printSample(out, samples[i]);
+  }
+  out << "\n      ]\n    }";
+}
+
+auto main(int argc, char** argv) -> int {
+  /*
+  Usage: bench.out [--warmup N] [--repetitions N] [scenario...]
+  Prints JSON to stdout, progress goes to stderr. Run from the repository
+  root. bench.out is built with the sanitizer and bench-fast.out without it,
+  compare the two for its cost.
+  */
+  std::vector<std::string_view> args;
+  for (int i = 1; i < argc; i++) {
+    args.emplace_back(argv[i]);
+  }
+
+  size_t warmup = 1;
+  size_t repetitions = 5;
+  std::vector<std::string_view> selected;
+  for (size_t i = 0; i < args.size(); i++) {
+    if ((args[i] == "--warmup" || args[i] == "--repetitions") &&
+        i + 1 < args.size()) {
+      const size_t value = std::stoul(std::string{args[i + 1]});
+      (args[i] == "--warmup" ? warmup : repetitions) = value;
+      i++;
+    } else {
+      selected.push_back(args[i]);
+    }
+  }
+  repetitions = std::max<size_t>(repetitions, 1);
+
+  for (const auto& name : selected) {
+    if (std::ranges::none_of(scenarios, [&](const Scenario& scenario) {
+          return scenario.name == name;
+        })) {
+      std::cerr << "Unknown scenario " << name << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Only speed is measured, let the ROMs run whatever they do
+  for (size_t kind = 0; kind < gb::error_kind_count; kind++) {
+    if (kind != (size_t)gb::ErrorKind::trap &&
+        kind != (size_t)gb::ErrorKind::debug_trap) {
+      gb::permit_error_kind((gb::ErrorKind)kind);
+    }
+  }
+
+  std::cout << std::setprecision(6) << "{\n"
+            << "  \"sanitizer\": " << std::boolalpha
+            << gb::checked_ints_by_default << ",\n"
+            << "  \"warmup\": " << warmup << ",\n"
+            << "  \"repetitions\": " << repetitions << ",\n"
+            << "  \"scenarios\": [";
+  bool first = true;
+  for (const auto& scenario : scenarios) {
+    if (!selected.empty() && std::ranges::find(selected, scenario.name) ==
+                                 selected.end()) {
+      continue;
+    }
+    std::cout << (first ? "\n" : ",\n");
+    printScenario(std::cout, scenario, warmup, repetitions);
+    first = false;
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+#include "batch.hpp"
+#include "cartridge.hpp"
+#include "error_handling.hpp"
+#include "gb.hpp"
+#include "io/frontend.hpp"
+#include "io/io.hpp"
+#include "utils/xxhash.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace gb;
+
+namespace {
+// How often the serial output and frame hashes are checked for completion
+constexpr uint64_t OUTPUT_CHECK_INTERVAL = 0x4000;
+
+class BatchFrontend : public IOFrontend {
+  std::string* output;
+  std::span<const uint64_t> hashFrames;
+  std::vector<uint64_t>* hashes;
+  uint64_t frameIndex = 0;
+
+  [[nodiscard]] auto isHashedFrame() const -> bool {
+    return hashes->size() < hashFrames.size() &&
+           hashFrames[hashes->size()] == frameIndex;
+  }
+
+ public:
+  Key keys = Key::NONE;
+
+  BatchFrontend(BatchResult& result, std::span<const uint64_t> hash_frames)
+      : output(&result.serial_output),
+        hashFrames(hash_frames),
+        hashes(&result.frame_hashes) {}
+
+  [[nodiscard]] auto isHashingDone() const -> bool {
+    return hashes->size() == hashFrames.size();
+  }
+
+  auto getKeyPressState() -> Key override { return keys; };
+  auto sendSerial(uint8_t value) -> void override {
+    output->push_back((char)value);
+  };
+  auto commitRender(Frame frame) -> void override {
+    if (isHashedFrame()) {
+      hashes->push_back(xxhash64(frame));
+    }
+    frameIndex++;
+  };
+  auto commitSkippedFrame(Frame) -> void override { frameIndex++; };
+  // Only the frames that are hashed need drawing
+  auto isFrameScheduled() -> bool override { return isHashedFrame(); };
+  auto isExitRequested() -> bool override { return false; };
+
+  auto try_flush_audio(std::span<std::pair<float, float>> samples)
+      -> std::optional<size_t> override {
+    return samples.size();
+  };
+};
+
+class WorkQueues {
+  /*
+  Every worker has its own queue of job indices and takes from the back of it.
+  Once that is empty it steals from the front of the others, so a worker that
+  was handed the short jobs helps out with the long ones. Jobs never create
+  more jobs: when every queue is empty the batch is done.
+  */
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+  };
+  std::vector<std::unique_ptr<Queue>> queues;
+
+ public:
+  WorkQueues(size_t workers, size_t job_count) {
+    for (size_t i = 0; i < workers; i++) {
+      queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t job = 0; job < job_count; job++) {
+      queues[job % workers]->jobs.push_back(job);
+    }
+  }
+
+  auto next(size_t worker) -> std::optional<size_t> {
+    for (size_t i = 0; i < queues.size(); i++) {
+      auto& queue = *queues[(worker + i) % queues.size()];
+      const std::scoped_lock lock(queue.mutex);
+      if (queue.jobs.empty()) {
+        continue;
+      }
+
+      size_t job;
+      if (i == 0) {
+        job = queue.jobs.back();
+        queue.jobs.pop_back();
+      } else {
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+      }
+      return job;
+    }
+    return std::nullopt;
+  }
+};
+
+auto find_stop_output(const BatchJob& job, const std::string& output)
+    -> std::optional<size_t> {
+  for (size_t i = 0; i < job.stop_on_output.size(); i++) {
+    if (output.find(job.stop_on_output[i]) != std::string::npos) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+auto run_inputs(const BatchJob& job,
+                GB& gameboy,
+                BatchFrontend& input,
+                BatchResult& result) -> void {
+  size_t next_input = 0;
+  while (gameboy.io.cycle < job.cycle_budget) {
+    while (next_input < job.inputs.size() &&
+           job.inputs[next_input].cycle <= gameboy.io.cycle) {
+      input.keys = job.inputs[next_input].keys;
+      next_input++;
+    }
+
+    // Stop at the next input event or output check, whichever is first
+    uint64_t end_cycle = job.cycle_budget;
+    if (next_input < job.inputs.size()) {
+      end_cycle = std::min(end_cycle, job.inputs[next_input].cycle);
+    }
+    if (not job.stop_on_output.empty() || not job.hash_frames.empty()) {
+      end_cycle =
+          std::min(end_cycle, gameboy.io.cycle + OUTPUT_CHECK_INTERVAL);
+    }
+
+    result.reason = gameboy.runFor(end_cycle - gameboy.io.cycle);
+    result.cycles = gameboy.io.cycle;
+    if (result.reason != StopReason::budget_exhausted) {
+      return;
+    }
+
+    result.matched_output = find_stop_output(job, result.serial_output);
+    if (result.matched_output.has_value()) {
+      return;
+    }
+    if (not job.hash_frames.empty() && input.isHashingDone()) {
+      return;
+    }
+  }
+}
+
+auto run_job(const BatchJob& job, BatchResult& result) -> void {
+  auto frontend = std::make_unique<BatchFrontend>(result, job.hash_frames);
+  BatchFrontend& input = *frontend;
+  GB gameboy(Cartridge::loadFromRom(job.rom_path), std::move(frontend));
+  for (const auto kind : job.permitted_errors) {
+    gameboy.errors.permit(kind);
+  }
+
+  try {
+    run_inputs(job, gameboy, input, result);
+  } catch (const std::exception& e) {
+    result.error = e.what();
+  }
+  result.error_count = gameboy.errors.errorCounts();
+}
+
+auto run_worker(size_t worker,
+                WorkQueues& queues,
+                std::span<const BatchJob> jobs,
+                std::span<BatchResult> results) -> void {
+  while (auto job = queues.next(worker)) {
+    try {
+      run_job(jobs[*job], results[*job]);
+    } catch (const std::exception& e) {
+      // The ROM couldn't be loaded
+      results[*job].error = e.what();
+    }
+  }
+}
+}  // namespace
+
+auto gb::run_batch(std::span<const BatchJob> jobs, size_t threads)
+    -> std::vector<BatchResult> {
+  std::vector<BatchResult> results(jobs.size());
+  if (jobs.empty()) {
+    return results;
+  }
+
+  if (threads == 0) {
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  threads = std::min(threads, jobs.size());
+
+  WorkQueues queues(threads, jobs.size());
+  {
+    std::vector<std::jthread> workers;
+    for (size_t worker = 0; worker < threads; worker++) {
+      workers.emplace_back(run_worker, worker, std::ref(queues), jobs,
+                           std::span{results});
+    }
+  }
+  return results;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "error_handling.hpp"
+#include "gb.hpp"
+#include "io/io.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace gb {
+
+struct InputEvent {
+  uint64_t cycle;  // Keys are pressed from this cycle until the next event
+  Key keys;
+};
+
+struct BatchJob {
+  std::string rom_path;
+  std::vector<InputEvent> inputs;  // Sorted by cycle
+  uint64_t cycle_budget;
+
+  // Permitted on top of default_error_policy()
+  std::vector<ErrorKind> permitted_errors;
+
+  // The job finishes early once its serial output contains any of these
+  std::vector<std::string> stop_on_output;
+
+  // Sorted indices of frames whose pixels are hashed, only these are drawn.
+  // The job finishes early once the last one is hashed.
+  std::vector<uint64_t> hash_frames;
+};
+
+struct BatchResult {
+  std::string serial_output;
+  StopReason reason = StopReason::budget_exhausted;
+  std::optional<std::string> error;  // Set if the emulator threw
+  uint64_t cycles = 0;
+  std::optional<size_t> matched_output;  // Index into 'stop_on_output'
+  std::array<unsigned, error_kind_count> error_count = {};
+  std::vector<uint64_t> frame_hashes;  // xxhash64 of each frame reached
+};
+
+// Runs every job on its own GB across a pool of 'threads' workers (defaults
+// to one per core). Results are in the same order as 'jobs'. Battery backed
+// RAM is never read from or written to a save file.
+auto run_batch(std::span<const BatchJob> jobs, size_t threads = 0)
+    -> std::vector<BatchResult>;
+
+}  // namespace gb
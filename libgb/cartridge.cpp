@@ -1,40 +1,80 @@
 #include "cartridge.hpp"
 
-#include <fstream>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using namespace gb;
 
-auto Cartridge::loadFromRom(std::string_view name) -> Cartridge {
-  std::ifstream input(std::string(name), std::ios::binary);
-  if (!input) {
-    throw std::runtime_error("Couldn't open ROM");
-  }
+auto Cartridge::loadFromRom(std::string_view name,
+                            std::optional<std::string_view> save_path)
+    -> Cartridge {
+  return Cartridge(RomImage::mapFile(name), save_path);
+}
+
+auto Cartridge::loadFromMemory(std::span<const uint8_t> rom) -> Cartridge {
+  return Cartridge(RomImage::borrow(rom), std::nullopt);
+}
 
-  return Cartridge(
-      std::vector<uint8_t>(std::istreambuf_iterator<char>(input), {}));
+auto Cartridge::loadFromBytes(std::vector<uint8_t> rom) -> Cartridge {
+  return Cartridge(RomImage::own(std::move(rom)), std::nullopt);
 }
 
-Cartridge::Cartridge(std::vector<uint8_t>&& rom_file)
-    : rom{std::move(rom_file)} {
+auto Cartridge::savePathFor(std::string_view rom_path) -> std::string {
+  return std::filesystem::path(rom_path).replace_extension(".sav").string();
+}
+
+Cartridge::Cartridge(RomImage&& rom_image,
+                     std::optional<std::string_view> save_path)
+    : rom{std::move(rom_image)} {
+  // Must at least contain the cartridge header
+  if (rom.size() < 0x150) {
+    throw std::runtime_error("ROM is too small to be a cartridge");
+  }
   populateMetadata(rom);
 
+  // Only RAM that survives power off is saved
+  if (not hasBattery() || ramSize == 0) {
+    save_path.reset();
+  }
+
   // Deduce controller from rom
   switch (controllerType) {
     case 0:  // ROM only
-      controller = make_rom_only_controller(rom);
+      controller = make_rom_only_controller(rom.bytes());
       break;
     case 1:
     case 2:
     case 3:  // MBC1 Controller
-      controller = make_mbc1(rom);
+      controller = make_mbc1(rom.bytes(), save_path);
+      break;
+    case 0x0F:
+    case 0x10:
+    case 0x11:
+    case 0x12:
+    case 0x13:  // MBC3 Controller (0x0F and 0x10 have a clock)
+      controller = make_mbc3(rom.bytes(), save_path);
+      break;
+    case 0x19:
+    case 0x1A:
+    case 0x1B:
+    case 0x1C:
+    case 0x1D:
+    case 0x1E:  // MBC5 Controller (0x1C - 0x1E have a rumble motor)
+      controller = make_mbc5(rom.bytes(), save_path);
       break;
     default:
       throw std::runtime_error("Cartridge controller not implemented");
   }
 }
 
-void Cartridge::populateMetadata(const std::vector<uint8_t>& rom) {
+void Cartridge::populateMetadata(const RomImage& rom) {
   /*
   Populates useful cartridge information from the ROM.
 
@@ -46,7 +86,8 @@ void Cartridge::populateMetadata(const std::vector<uint8_t>& rom) {
   target = Target{rom[0x143]};
 
   // Name in upper ASCII
-  gameName = std::string(rom.begin() + 0x134, rom.begin() + 0x142);
+  const auto title = rom.bytes().subspan(0x134, 0x142 - 0x134);
+  gameName = std::string(title.begin(), title.end());
 
   // Describes the cartridge technology used
   // This might be misrepresented by the game -- could cause errors later
@@ -66,3 +107,39 @@ auto Cartridge::read(uint16_t addr) const -> Byte {
 void Cartridge::write(uint16_t addr, Byte value) {
   controller->write(addr, value);
 }
+
+auto Cartridge::attach(PageTable& pages,
+                       const uint64_t& cycle,
+                       ErrorPolicy& errors) -> void {
+  controller->attach(pages, cycle, errors);
+}
+
+auto Cartridge::hasBattery() const -> bool {
+  switch (controllerType) {
+    case 0x03:  // MBC1+RAM+BATTERY
+    case 0x0F:  // MBC3+TIMER+BATTERY
+    case 0x10:  // MBC3+TIMER+RAM+BATTERY
+    case 0x13:  // MBC3+RAM+BATTERY
+    case 0x1B:  // MBC5+RAM+BATTERY
+    case 0x1E:  // MBC5+RUMBLE+RAM+BATTERY
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto Cartridge::flush() -> void {
+  controller->flush();
+}
+
+auto Cartridge::checksum() const -> uint16_t {
+  return (uint16_t)((rom[0x14E] << 8U) | rom[0x14F]);
+}
+
+auto Cartridge::saveState(StateWriter& writer) const -> void {
+  controller->saveState(writer);
+}
+
+auto Cartridge::loadState(StateReader& reader) -> void {
+  controller->loadState(reader);
+}
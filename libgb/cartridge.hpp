@@ -1,10 +1,14 @@
 #pragma once
 
 #include "controller/controller.hpp"
+#include "error_handling.hpp"
+#include "rom_image.hpp"
 #include "utils/checked_int.hpp"
+#include "utils/save_state.hpp"
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <span>
 #include <string>
 #include <string_view>
@@ -18,7 +22,7 @@ class Cartridge {
     Color = 0x80,
   };
 
-  std::vector<uint8_t> rom;
+  RomImage rom;
   std::unique_ptr<Controller> controller;
 
   uint8_t controllerType = 0;  // Enum of controller technologies
@@ -28,20 +32,50 @@ class Cartridge {
   std::string gameName;
   Target target = Target::Classic;
 
-  explicit Cartridge(std::vector<uint8_t>&& rom);
+  Cartridge(RomImage&& rom, std::optional<std::string_view> save_path);
 
  public:
-  static auto loadFromRom(std::string_view name) -> Cartridge;
+  // Battery backed RAM is persisted to 'save_path', when one is given
+  static auto loadFromRom(std::string_view name,
+                          std::optional<std::string_view> save_path = {})
+      -> Cartridge;
+  // The caller keeps ownership of 'rom', it must outlive the cartridge
+  static auto loadFromMemory(std::span<const uint8_t> rom) -> Cartridge;
+  static auto loadFromBytes(std::vector<uint8_t> rom) -> Cartridge;
 
-  void populateMetadata(const std::vector<uint8_t>& rom);
+  // The conventional save file, next to the ROM with a .sav extension
+  static auto savePathFor(std::string_view rom_path) -> std::string;
+
+  void populateMetadata(const RomImage& rom);
 
   [[nodiscard]] auto read(uint16_t addr) const -> Byte;
   auto write(uint16_t addr, Byte value) -> void;
+
+  // Let the controller map its banks directly into the page table
+  auto attach(PageTable& pages, const uint64_t& cycle, ErrorPolicy& errors)
+      -> void;
+
+  [[nodiscard]] auto hasBattery() const -> bool;
+  auto flush() -> void;
+
+  // Global checksum from the cartridge header, identifies the ROM
+  [[nodiscard]] auto checksum() const -> uint16_t;
+
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
 };
 
 // Controller type
-auto make_mbc1(std::span<uint8_t> rom) -> std::unique_ptr<Controller>;
-auto make_rom_only_controller(std::span<uint8_t> rom)
+auto make_mbc1(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller>;
+auto make_mbc3(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller>;
+auto make_mbc5(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller>;
+auto make_rom_only_controller(std::span<const uint8_t> rom)
     -> std::unique_ptr<Controller>;
 
 }  // namespace gb
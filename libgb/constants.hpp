@@ -5,6 +5,8 @@
 namespace gb {
 
 static constexpr double FRAMETIME = 1.0 / 59.7;  // 59.7 Hz
+static constexpr uint64_t CYCLES_PER_FRAME = 70224 / 4;
+static constexpr uint64_t CYCLES_PER_SECOND = 4194304 / 4;
 static constexpr uint8_t SCREEN_WIDTH = 160;
 static constexpr uint8_t SCREEN_HEIGHT = 144;
 
@@ -0,0 +1,131 @@
+#include "cartridge_ram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace gb;
+
+namespace {
+#ifdef __unix__
+constexpr bool can_map_save_files = not checked_ints_by_default;
+#else
+constexpr bool can_map_save_files = false;
+#endif
+}  // namespace
+
+CartridgeRam::CartridgeRam(size_t size,
+                           std::optional<std::string_view> save_path) {
+  if (size == 0 || not save_path.has_value()) {
+    owned.resize(size);
+    bytes = owned;
+    return;
+  }
+  savePath = std::string(*save_path);
+
+  if constexpr (can_map_save_files) {
+#ifdef __unix__
+    const int file = open(savePath->c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                          0644);
+    if (file < 0) {
+      throw std::runtime_error(
+          std::format("Couldn't open save file '{}'", *savePath));
+    }
+
+    // New (or truncated) saves are zero filled up to the RAM size
+    struct stat info = {};
+    if (fstat(file, &info) != 0 ||
+        ((size_t)info.st_size < size && ftruncate(file, (off_t)size) != 0)) {
+      close(file);
+      throw std::runtime_error(
+          std::format("Couldn't resize save file '{}'", *savePath));
+    }
+
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      throw std::runtime_error(
+          std::format("Couldn't map save file '{}'", *savePath));
+    }
+    mappingSize = size;
+    bytes = {static_cast<Byte*>(mapping), size};
+#endif
+  } else {
+    // RAM is undefined until written, unless the save file says otherwise
+    owned.resize(size);
+    bytes = owned;
+
+    std::ifstream input(*savePath, std::ios::binary);
+    std::vector<char> contents(size);
+    input.read(contents.data(), (std::streamsize)size);
+    for (size_t i = 0; i < (size_t)input.gcount(); i++) {
+      owned[i] = Byte{(uint8_t)contents[i]};
+    }
+  }
+}
+
+CartridgeRam::~CartridgeRam() {
+  if (mapping != nullptr) {
+#ifdef __unix__
+    // The kernel writes back the shared pages
+    munmap(mapping, mappingSize);
+#endif
+    return;
+  }
+
+  try {
+    flush();
+  } catch (const std::exception&) {
+    // Destructors cannot report failure, call flush() to find out
+  }
+}
+
+auto CartridgeRam::flush() -> void {
+  if (not savePath.has_value()) {
+    return;
+  }
+
+  if (mapping != nullptr) {
+#ifdef __unix__
+    if (msync(mapping, mappingSize, MS_SYNC) != 0) {
+      throw std::runtime_error(
+          std::format("Couldn't write save file '{}'", *savePath));
+    }
+#endif
+    return;
+  }
+
+  std::vector<char> contents(bytes.size());
+  for (size_t i = 0; i < bytes.size(); i++) {
+    // Never written bytes are saved as 0
+    contents[i] = (char)bytes[i].decay_or(0);
+  }
+  std::ofstream output(*savePath, std::ios::binary | std::ios::trunc);
+  output.write(contents.data(), (std::streamsize)contents.size());
+  if (!output) {
+    throw std::runtime_error(
+        std::format("Couldn't write save file '{}'", *savePath));
+  }
+}
+
+auto CartridgeRam::saveState(StateWriter& writer) const -> void {
+  writer.writeBytes(bytes.data(), bytes.size_bytes());
+}
+
+auto CartridgeRam::loadState(StateReader& reader) -> void {
+  reader.readBytes(bytes.data(), bytes.size_bytes());
+}
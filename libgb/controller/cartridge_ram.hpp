@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../utils/checked_int.hpp"
+#include "../utils/save_state.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gb {
+
+class CartridgeRam {
+  /*
+  External RAM on the cartridge. Battery backed RAM is persisted to a save
+  file. Where a Byte is a plain byte the file is mapped shared, so every write
+  by the game lands in the page cache with no extra work and the OS writes it
+  back lazily. Otherwise (checked builds) the file is read on construction and
+  written back by flush().
+  */
+  std::vector<Byte> owned;
+  std::span<Byte> bytes;
+
+  std::optional<std::string> savePath;
+  void* mapping = nullptr;
+  size_t mappingSize = 0;
+
+ public:
+  explicit CartridgeRam(size_t size,
+                        std::optional<std::string_view> save_path = {});
+  CartridgeRam(const CartridgeRam&) = delete;
+  auto operator=(const CartridgeRam&) -> CartridgeRam& = delete;
+  ~CartridgeRam();
+
+  [[nodiscard]] auto data() -> Byte* { return bytes.data(); }
+  [[nodiscard]] auto size() const -> size_t { return bytes.size(); }
+  [[nodiscard]] auto operator[](size_t index) -> Byte& { return bytes[index]; }
+  [[nodiscard]] auto operator[](size_t index) const -> const Byte& {
+    return bytes[index];
+  }
+
+  // Make sure the save file is up to date (eg. before exiting)
+  auto flush() -> void;
+
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
+};
+
+}  // namespace gb
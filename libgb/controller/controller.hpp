@@ -1,18 +1,71 @@
 #pragma once
 
+#include "../error_handling.hpp"
+#include "../page_table.hpp"
 #include "../utils/checked_int.hpp"
+#include "../utils/save_state.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
 
 namespace gb {
 class Controller {
+ protected:
+  PageTable* pages = nullptr;
+
+  // Emulated M-cycles since power on, for controllers with a clock
+  const uint64_t* cycle = nullptr;
+
+  // Owned by the emulator, reached through attach()
+  ErrorPolicy* errors = nullptr;
+
+  // Publish the currently selected banks to the page table (if attached).
+  // Must be called whenever a bank switch changes the host memory behind an
+  // address.
+  virtual auto updatePageTable() -> void = 0;
+
  public:
   Controller() = default;
   Controller(const Controller&) = delete;
   auto operator=(const Controller&) -> Controller& = delete;
   virtual ~Controller() = default;
 
+  auto attach(PageTable& table,
+              const uint64_t& cycle_counter,
+              ErrorPolicy& error_policy) -> void {
+    pages = &table;
+    cycle = &cycle_counter;
+    errors = &error_policy;
+    updatePageTable();
+  }
+
+  // Cartridge RAM size declared by the header
+  static auto ramSizeFromHeader(std::span<const uint8_t> rom) -> size_t {
+    switch (rom[0x149]) {
+      case 1:
+        return 0x800;
+      case 2:
+        return 0x2000;
+      case 3:
+        return 0x8000;
+      case 4:
+        return 0x20000;
+      case 5:
+        return 0x10000;
+      default:
+        return 0;
+    }
+  }
+
   [[nodiscard]] virtual auto read(uint16_t addr) const -> Byte = 0;
   virtual void write(uint16_t addr, Byte value) = 0;
+
+  // Bank selection and cartridge RAM (the ROM itself is not saved)
+  virtual auto saveState(StateWriter&) const -> void = 0;
+  virtual auto loadState(StateReader&) -> void = 0;
+
+  // Write battery backed RAM to its save file, if the cartridge has one
+  virtual auto flush() -> void {}
 };
 }  // namespace gb
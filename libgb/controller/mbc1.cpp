@@ -1,12 +1,17 @@
+#include "cartridge_ram.hpp"
 #include "controller.hpp"
 
 #include "../error_handling.hpp"
 
-#include <array>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <memory>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <string_view>
 
 using namespace gb;
 
@@ -21,13 +26,61 @@ class MBC1 : public Controller {
   uint8_t romBank = 1;
   uint8_t ramBank = 0;
 
-  std::span<uint8_t> rom;
+  std::span<const uint8_t> rom;
+  size_t romBankCount;
 
-  // Allocate enough ram for the full 32KByte RAM mode
-  std::array<Byte, 0x8000> ram = {};
+  // Recomputed on every bank switch so reads are a single indexed load
+  const uint8_t* romBankBase = nullptr;
+
+  // Sized by the header, out of range RAM banks wrap
+  CartridgeRam ram;
+  size_t ramBankCount;
+
+  // Bank switches only remap the switchable region that changed
+  auto mapRomBank() -> void {
+    // Out of range banks wrap, the unused high bank bits aren't connected
+    romBankBase = &rom[0x4000 * (romBank % romBankCount)];
+    if (pages != nullptr) {
+      pages->mapRom(0x4000, 0x4000, romBankBase);
+    }
+  }
+
+  auto mapRamBank() -> void {
+    if (pages == nullptr) {
+      return;
+    }
+    pages->mapRam(0xA000, 0x2000, &ram[0x2000 * (ramBank % ramBankCount)]);
+  }
+
+  auto selectRomBank(uint8_t bank) -> void {
+    if (bank != romBank) {
+      romBank = bank;
+      mapRomBank();
+    }
+  }
+
+  auto updatePageTable() -> void final {
+    if (pages == nullptr) {
+      return;
+    }
+    pages->mapRom(0x0000, 0x4000, rom.data());
+    mapRomBank();
+    mapRamBank();
+  }
 
  public:
-  explicit MBC1(std::span<uint8_t> rom) : rom{rom} {}
+  MBC1(std::span<const uint8_t> rom,
+       std::optional<std::string_view> save_path)
+      : rom{rom},
+        romBankCount{rom.size() / 0x4000},
+        // Smaller RAMs (and carts without any) are still given a whole bank
+        ram(std::max<size_t>(ramSizeFromHeader(rom), 0x2000), save_path),
+        ramBankCount{ram.size() / 0x2000} {
+    if (romBankCount < 2) {
+      throw std::runtime_error("ROM is too small for an MBC1 cartridge");
+    }
+    mapRomBank();
+  }
 
   [[nodiscard]] auto read(uint16_t addr) const -> Byte final {
     switch (addr >> 12U) {
@@ -41,18 +94,16 @@ class MBC1 : public Controller {
       case 4:
       case 5:
       case 6:
-      case 7: {
-        uint16_t bankOffset = addr - 0x4000;
-        return Byte{rom[(0x4000 * romBank) + bankOffset]};
-      }
+      case 7:
+        return Byte{romBankBase[addr - 0x4000]};
       // Cartridge RAM (Selectable in 32KByte RAM mode)
       case 0xA:
       case 0xB: {
         uint16_t bankOffset = addr - 0xA000;
-        return ram.at((0x2000 * ramBank) + bankOffset);
+        return ram[(0x2000 * (ramBank % ramBankCount)) + bankOffset];
       }
       default:
-        throw_error([&] {
+        report_error(*errors, [&] {
           return IllegalMemoryAddress(
               std::format("Cannot read ROM address {:#06x}", addr));
         });
@@ -74,9 +125,9 @@ class MBC1 : public Controller {
       case 2:
       case 3:
         if ((value & 0x1F_B) != 0_B) {
-          romBank = (value & 0x1F_B).decay();
+          selectRomBank((value & 0x1F_B).decay());
         } else {
-          romBank = 1;  // Cannot select bank 0
+          selectRomBank(1);  // Cannot select bank 0
         }
         break;
 
@@ -87,9 +138,10 @@ class MBC1 : public Controller {
       case 5:
         if (bankedRamMode) {
           ramBank = (value & 0x03_B).decay();
+          mapRamBank();
         } else {
-          romBank =
-              (((value & 0x03_B) << 5U) | (Byte{romBank} & 0x1F_B)).decay();
+          selectRomBank(
+              (((value & 0x03_B) << 5U) | (Byte{romBank} & 0x1F_B)).decay());
         }
         break;
 
@@ -104,22 +156,44 @@ class MBC1 : public Controller {
       case 0xA:
       case 0xB: {
         uint16_t bankOffset = addr - 0xA000;
-        ram[(0x2000 * ramBank) + bankOffset] = value;
+        ram[(0x2000 * (ramBank % ramBankCount)) + bankOffset] = value;
         break;
       }
 
       default:
-        throw_error([&] {
+        report_error(*errors, [&] {
           return IllegalMemoryAddress(
               std::format("Cannot write to ROM address {:#06x}", addr));
         });
         break;
     }
   }
+
+  auto saveState(StateWriter& writer) const -> void final {
+    writer.write(bankedRamMode);
+    writer.write(ramEnabled);
+    writer.write(romBank);
+    writer.write(ramBank);
+    ram.saveState(writer);
+  }
+
+  auto loadState(StateReader& reader) -> void final {
+    reader.read(bankedRamMode);
+    reader.read(ramEnabled);
+    reader.read(romBank);
+    reader.read(ramBank);
+    ram.loadState(reader);
+    mapRomBank();
+    updatePageTable();
+  }
+
+  auto flush() -> void final { ram.flush(); }
 };
 
 namespace gb {
-auto make_mbc1(std::span<uint8_t> rom) -> std::unique_ptr<Controller> {
-  return std::make_unique<MBC1>(rom);
+auto make_mbc1(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller> {
+  return std::make_unique<MBC1>(rom, save_path);
 }
 }  // namespace gb
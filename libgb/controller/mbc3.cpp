@@ -0,0 +1,270 @@
+#include "cartridge_ram.hpp"
+#include "controller.hpp"
+
+#include "../constants.hpp"
+#include "../error_handling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <span>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+using namespace gb;
+
+class MBC3 : public Controller {
+  // Real time clock registers, mapped by RAM banks 0x08 - 0x0C
+  using Clock = std::array<uint8_t, 5>;
+  static constexpr size_t SECONDS = 0;
+  static constexpr size_t MINUTES = 1;
+  static constexpr size_t HOURS = 2;
+  static constexpr size_t DAYS_LOW = 3;
+  static constexpr size_t DAYS_HIGH = 4;  // Bit 0: day bit 8, 6: halt, 7: carry
+  static constexpr Clock CLOCK_MASKS = {0x3F, 0x3F, 0x1F, 0xFF, 0xC1};
+
+  static constexpr uint8_t DAY_HIGH_BIT = 0x01;
+  static constexpr uint8_t HALT_BIT = 0x40;
+  static constexpr uint8_t DAY_CARRY_BIT = 0x80;
+
+  bool ramEnabled = false;  // Also enables the clock registers
+
+  // 7-bit ROM bank, RAM bank 0 - 3 or a clock register 0x08 - 0x0C
+  uint8_t romBank = 1;
+  uint8_t ramBank = 0;
+
+  // The clock is counted in emulated cycles, so it runs at the same rate no
+  // matter how fast the emulator does. It is only brought up to date when the
+  // game can observe it.
+  Clock clock = {};
+  Clock latched = {};
+  uint8_t lastLatchWrite = 0xFF;
+  uint64_t clockUpdatedCycle = 0;
+  uint64_t clockSubsecondCycles = 0;
+
+  std::span<const uint8_t> rom;
+  size_t romBankCount;
+
+  CartridgeRam ram;
+  size_t ramBankCount;
+
+  // Recomputed on every bank switch so accesses are a single indexed load.
+  // Null when a clock register (or nothing) is selected.
+  const uint8_t* romBankBase = nullptr;
+  Byte* ramBankBase = nullptr;
+
+  // Bank switches only remap the switchable region that changed
+  auto selectRomBank() -> void {
+    const uint8_t* base = &rom[0x4000 * (romBank % romBankCount)];
+    if (base != romBankBase) {
+      romBankBase = base;
+      if (pages != nullptr) {
+        pages->mapRom(0x4000, 0x4000, romBankBase);
+      }
+    }
+  }
+
+  auto selectRamBank() -> void {
+    Byte* base = nullptr;
+    if (ramEnabled && ramBank < ramBankCount) {
+      base = &ram[0x2000 * ramBank];
+    }
+    if (base != ramBankBase) {
+      ramBankBase = base;
+      if (pages != nullptr) {
+        pages->mapRam(0xA000, 0x2000, ramBankBase);
+      }
+    }
+  }
+
+  auto updatePageTable() -> void final {
+    if (pages == nullptr) {
+      return;
+    }
+    pages->mapRom(0x0000, 0x4000, rom.data());
+    pages->mapRom(0x4000, 0x4000, romBankBase);
+    pages->mapRam(0xA000, 0x2000, ramBankBase);
+  }
+
+  [[nodiscard]] auto isClockSelected() const -> bool {
+    return ramEnabled && ramBank >= 0x08 && ramBank <= 0x0C;
+  }
+
+  auto updateClock() -> void {
+    /*
+    Adds the seconds elapsed since the last update. The cycle counter restarts
+    on reset, time doesn't pass until it catches up again.
+    */
+    const uint64_t now = cycle == nullptr ? 0 : *cycle;
+    const uint64_t elapsed = now > clockUpdatedCycle ? now - clockUpdatedCycle
+                                                     : 0;
+    clockUpdatedCycle = now;
+    if ((clock[DAYS_HIGH] & HALT_BIT) != 0) {
+      return;
+    }
+
+    clockSubsecondCycles += elapsed;
+    const uint64_t seconds =
+        clock[SECONDS] + (clockSubsecondCycles / CYCLES_PER_SECOND);
+    clockSubsecondCycles %= CYCLES_PER_SECOND;
+
+    const uint64_t minutes = clock[MINUTES] + (seconds / 60);
+    const uint64_t hours = clock[HOURS] + (minutes / 60);
+    uint64_t days =
+        (clock[DAYS_LOW] | ((clock[DAYS_HIGH] & DAY_HIGH_BIT) << 8U)) +
+        (hours / 24);
+    if (days >= 512) {
+      clock[DAYS_HIGH] |= DAY_CARRY_BIT;
+      days %= 512;
+    }
+
+    clock[SECONDS] = (uint8_t)(seconds % 60);
+    clock[MINUTES] = (uint8_t)(minutes % 60);
+    clock[HOURS] = (uint8_t)(hours % 24);
+    clock[DAYS_LOW] = (uint8_t)(days & 0xFFU);
+    clock[DAYS_HIGH] =
+        (uint8_t)((clock[DAYS_HIGH] & ~DAY_HIGH_BIT) | (days >> 8U));
+  }
+
+ public:
+  MBC3(std::span<const uint8_t> rom,
+       std::optional<std::string_view> save_path)
+      : rom{rom},
+        romBankCount{rom.size() / 0x4000},
+        // Smaller RAMs are still given a whole bank
+        ram(std::max<size_t>(ramSizeFromHeader(rom), 0x2000), save_path),
+        ramBankCount{(ramSizeFromHeader(rom) + 0x1FFF) / 0x2000} {
+    if (romBankCount < 2) {
+      throw std::runtime_error("ROM is too small for an MBC3 cartridge");
+    }
+    selectRomBank();
+    selectRamBank();
+  }
+
+  [[nodiscard]] auto read(uint16_t addr) const -> Byte final {
+    switch (addr >> 12U) {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+        return Byte{rom[addr]};
+      case 4:
+      case 5:
+      case 6:
+      case 7:
+        return Byte{romBankBase[addr - 0x4000]};
+      case 0xA:
+      case 0xB:
+        if (ramBankBase != nullptr) {
+          return ramBankBase[addr - 0xA000];
+        }
+        if (isClockSelected()) {
+          // Games only ever see the latched copy of the clock
+          return Byte{latched[ramBank - 0x08]};
+        }
+        return 0xFF_B;  // Disabled RAM floats high
+      default:
+        report_error(*errors, [&] {
+          return IllegalMemoryAddress(
+              std::format("Cannot read ROM address {:#06x}", addr));
+        });
+        return {};
+    }
+  }
+
+  auto write(uint16_t addr, Byte value) -> void final {
+    switch (addr >> 12U) {
+      // 0x0000 - 0x1FFF enables RAM and the clock
+      case 0:
+      case 1:
+        ramEnabled = (value & 0x0F_B) == 0x0A_B;
+        selectRamBank();
+        break;
+      // 0x2000 - 0x3FFF selects ROM bank
+      case 2:
+      case 3:
+        romBank = (value & 0x7F_B).decay();
+        if (romBank == 0) {
+          romBank = 1;  // Cannot select bank 0
+        }
+        selectRomBank();
+        break;
+      // 0x4000 - 0x5FFF selects a RAM bank or clock register
+      case 4:
+      case 5:
+        ramBank = value.decay();
+        selectRamBank();
+        break;
+      // 0x6000 - 0x7FFF latches the clock on a 0 then 1 write
+      case 6:
+      case 7:
+        if (lastLatchWrite == 0x00 && value == 0x01_B) {
+          updateClock();
+          latched = clock;
+        }
+        lastLatchWrite = value.decay();
+        break;
+      case 0xA:
+      case 0xB:
+        if (ramBankBase != nullptr) {
+          ramBankBase[addr - 0xA000] = value;
+        } else if (isClockSelected()) {
+          // Count up to this write before replacing the register
+          updateClock();
+          const size_t index = ramBank - 0x08;
+          clock[index] = value.decay() & CLOCK_MASKS[index];
+          if (index == SECONDS) {
+            clockSubsecondCycles = 0;
+          }
+        }
+        break;
+      default:
+        report_error(*errors, [&] {
+          return IllegalMemoryAddress(
+              std::format("Cannot write to ROM address {:#06x}", addr));
+        });
+        break;
+    }
+  }
+
+  auto saveState(StateWriter& writer) const -> void final {
+    writer.write(ramEnabled);
+    writer.write(romBank);
+    writer.write(ramBank);
+    writer.write(clock);
+    writer.write(latched);
+    writer.write(lastLatchWrite);
+    writer.write(clockUpdatedCycle);
+    writer.write(clockSubsecondCycles);
+    ram.saveState(writer);
+  }
+
+  auto loadState(StateReader& reader) -> void final {
+    reader.read(ramEnabled);
+    reader.read(romBank);
+    reader.read(ramBank);
+    reader.read(clock);
+    reader.read(latched);
+    reader.read(lastLatchWrite);
+    reader.read(clockUpdatedCycle);
+    reader.read(clockSubsecondCycles);
+    ram.loadState(reader);
+    selectRomBank();
+    selectRamBank();
+    updatePageTable();
+  }
+
+  auto flush() -> void final { ram.flush(); }
+};
+
+namespace gb {
+auto make_mbc3(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller> {
+  return std::make_unique<MBC3>(rom, save_path);
+}
+}  // namespace gb
@@ -0,0 +1,181 @@
+#include "cartridge_ram.hpp"
+#include "controller.hpp"
+
+#include "../error_handling.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <span>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+using namespace gb;
+
+class MBC5 : public Controller {
+  bool ramEnabled = false;
+
+  // 9-bit ROM bank (up to 8MByte), 4-bit RAM bank (up to 128KByte)
+  uint16_t romBank = 1;
+  uint8_t ramBank = 0;
+
+  std::span<const uint8_t> rom;
+  size_t romBankCount;
+
+  CartridgeRam ram;
+  size_t ramBankCount;
+
+  // Recomputed on every bank switch so accesses are a single indexed load.
+  // Unselected (or disabled) RAM is null.
+  const uint8_t* romBankBase = nullptr;
+  Byte* ramBankBase = nullptr;
+
+  // Bank switches only remap the switchable region that changed
+  auto selectRomBank() -> void {
+    // Out of range banks wrap, the unused high bank bits aren't connected
+    const uint8_t* base = &rom[0x4000 * (romBank % romBankCount)];
+    if (base != romBankBase) {
+      romBankBase = base;
+      if (pages != nullptr) {
+        pages->mapRom(0x4000, 0x4000, romBankBase);
+      }
+    }
+  }
+
+  auto selectRamBank() -> void {
+    Byte* base = nullptr;
+    if (ramEnabled && ramBankCount != 0) {
+      base = &ram[0x2000 * (ramBank % ramBankCount)];
+    }
+    if (base != ramBankBase) {
+      ramBankBase = base;
+      if (pages != nullptr) {
+        pages->mapRam(0xA000, 0x2000, ramBankBase);
+      }
+    }
+  }
+
+  auto updatePageTable() -> void final {
+    if (pages == nullptr) {
+      return;
+    }
+    pages->mapRom(0x0000, 0x4000, rom.data());
+    pages->mapRom(0x4000, 0x4000, romBankBase);
+    pages->mapRam(0xA000, 0x2000, ramBankBase);
+  }
+
+ public:
+  MBC5(std::span<const uint8_t> rom,
+       std::optional<std::string_view> save_path)
+      : rom{rom},
+        romBankCount{rom.size() / 0x4000},
+        // Smaller RAMs are still given a whole bank
+        ram(std::max<size_t>(ramSizeFromHeader(rom), 0x2000), save_path),
+        ramBankCount{(ramSizeFromHeader(rom) + 0x1FFF) / 0x2000} {
+    if (romBankCount < 2) {
+      throw std::runtime_error("ROM is too small for an MBC5 cartridge");
+    }
+    selectRomBank();
+    selectRamBank();
+  }
+
+  [[nodiscard]] auto read(uint16_t addr) const -> Byte final {
+    switch (addr >> 12U) {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+        return Byte{rom[addr]};
+      case 4:
+      case 5:
+      case 6:
+      case 7:
+        return Byte{romBankBase[addr - 0x4000]};
+      case 0xA:
+      case 0xB:
+        if (ramBankBase == nullptr) {
+          return 0xFF_B;  // Disabled RAM floats high
+        }
+        return ramBankBase[addr - 0xA000];
+      default:
+        report_error(*errors, [&] {
+          return IllegalMemoryAddress(
+              std::format("Cannot read ROM address {:#06x}", addr));
+        });
+        return {};
+    }
+  }
+
+  auto write(uint16_t addr, Byte value) -> void final {
+    switch (addr >> 12U) {
+      // 0x0000 - 0x1FFF enables RAM
+      case 0:
+      case 1:
+        ramEnabled = (value & 0x0F_B) == 0x0A_B;
+        selectRamBank();
+        break;
+      // 0x2000 - 0x2FFF selects the low 8 bits of the ROM bank (0 is allowed)
+      case 2:
+        romBank = (romBank & 0x100U) | value.decay();
+        selectRomBank();
+        break;
+      // 0x3000 - 0x3FFF selects the 9th bit of the ROM bank
+      case 3:
+        romBank = (romBank & 0xFFU) | ((value & 0x01_B).decay() << 8U);
+        selectRomBank();
+        break;
+      // 0x4000 - 0x5FFF selects the RAM bank (bit 3 drives rumble carts)
+      case 4:
+      case 5:
+        ramBank = (value & 0x0F_B).decay();
+        selectRamBank();
+        break;
+      // 0x6000 - 0x7FFF is unused
+      case 6:
+      case 7:
+        break;
+      case 0xA:
+      case 0xB:
+        if (ramBankBase != nullptr) {
+          ramBankBase[addr - 0xA000] = value;
+        }
+        break;
+      default:
+        report_error(*errors, [&] {
+          return IllegalMemoryAddress(
+              std::format("Cannot write to ROM address {:#06x}", addr));
+        });
+        break;
+    }
+  }
+
+  auto saveState(StateWriter& writer) const -> void final {
+    writer.write(ramEnabled);
+    writer.write(romBank);
+    writer.write(ramBank);
+    ram.saveState(writer);
+  }
+
+  auto loadState(StateReader& reader) -> void final {
+    reader.read(ramEnabled);
+    reader.read(romBank);
+    reader.read(ramBank);
+    ram.loadState(reader);
+    selectRomBank();
+    selectRamBank();
+    updatePageTable();
+  }
+
+  auto flush() -> void final { ram.flush(); }
+};
+
+namespace gb {
+auto make_mbc5(std::span<const uint8_t> rom,
+               std::optional<std::string_view> save_path)
+    -> std::unique_ptr<Controller> {
+  return std::make_unique<MBC5>(rom, save_path);
+}
+}  // namespace gb
@@ -1,6 +1,8 @@
 #include "../error_handling.hpp"
 #include "controller.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <memory>
@@ -9,10 +11,20 @@
 using namespace gb;
 
 class RomOnlyController : public Controller {
-  std::span<uint8_t> rom;
+  std::span<const uint8_t> rom;
+
+  auto updatePageTable() -> void final {
+    if (pages == nullptr) {
+      return;
+    }
+    // Only whole pages are mapped, the zero padding stays on the slow path
+    const size_t mapped_size =
+        std::min<size_t>(rom.size(), 0x8000) & ~(PageTable::PAGE_SIZE - 1);
+    pages->mapRom(0x0000, mapped_size, rom.data());
+  }
 
  public:
-  explicit RomOnlyController(std::span<uint8_t> rom) : rom{rom} {}
+  explicit RomOnlyController(std::span<const uint8_t> rom) : rom{rom} {}
 
   [[nodiscard]] auto read(uint16_t addr) const -> Byte final {
     if (addr < rom.size()) {
@@ -24,16 +36,20 @@ class RomOnlyController : public Controller {
   auto write(uint16_t addr, Byte value) -> void final {
     // ROM should just ignore write errors (when UBSAN is off)
     // Some games write to the controller even if there's just ROM
-    throw_error([&] {
+    report_error(*errors, [&] {
       return IllegalMemoryWrite(
           std::format("Attempt to write {:#04x} to read-only address @ {:#06x}",
                       value.decay(), addr));
     });
   }
+
+  // Nothing but ROM, which is never saved
+  auto saveState(StateWriter&) const -> void final {}
+  auto loadState(StateReader&) -> void final {}
 };
 
 namespace gb {
-auto make_rom_only_controller(std::span<uint8_t> rom)
+auto make_rom_only_controller(std::span<const uint8_t> rom)
     -> std::unique_ptr<Controller> {
   return std::make_unique<RomOnlyController>(rom);
 }
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gb {
+
+/*
+The CPU caches straight-line runs of instructions (blocks) from ROM and high
+RAM. A block ends with its first jump, call, return, HALT or IME change, which
+may still be executed as part of it. Instructions with fixed timing make up
+the rest, so the cycles a block takes before its last instruction are known
+when it is decoded.
+*/
+enum class BlockRole : uint8_t {
+  straight,    // Fixed timing, execution continues with the next instruction
+  ends_block,  // Changes control flow or IME, always the last instruction
+  not_cached,  // Traps and STOP are only ever single stepped
+};
+
+[[nodiscard]] constexpr auto block_role(uint8_t opcode) -> BlockRole {
+  switch (opcode) {
+    case 0x10:  // STOP
+    case 0xD3:  // Trap
+    case 0xDB:
+    case 0xDD:
+    case 0xE3:  // DebugTrap
+    case 0xE4:
+    case 0xEB:
+    case 0xEC:
+    case 0xED:
+    case 0xF4:
+    case 0xFC:
+    case 0xFD:
+      return BlockRole::not_cached;
+    case 0x18:  // JR n
+    case 0x20:  // JR cc,n
+    case 0x28:
+    case 0x30:
+    case 0x38:
+    case 0x76:  // HALT
+    case 0xC0:  // RET cc
+    case 0xC8:
+    case 0xD0:
+    case 0xD8:
+    case 0xC2:  // JP cc,nn
+    case 0xCA:
+    case 0xD2:
+    case 0xDA:
+    case 0xC4:  // CALL cc,nn
+    case 0xCC:
+    case 0xD4:
+    case 0xDC:
+    case 0xC3:  // JP nn
+    case 0xC9:  // RET
+    case 0xCD:  // CALL nn
+    case 0xD9:  // RETI
+    case 0xE9:  // JP (HL)
+    case 0xC7:  // RST n
+    case 0xCF:
+    case 0xD7:
+    case 0xDF:
+    case 0xE7:
+    case 0xEF:
+    case 0xF7:
+    case 0xFF:
+    case 0xF3:  // DI
+    case 0xFB:  // EI
+      return BlockRole::ends_block;
+    default:
+      return BlockRole::straight;
+  }
+}
+
+// Bytes taken by the opcode and its operands
+[[nodiscard]] constexpr auto instruction_length(uint8_t opcode) -> uint8_t {
+  switch (opcode) {
+    case 0x01:  // LD rr,nn
+    case 0x11:
+    case 0x21:
+    case 0x31:
+    case 0x08:  // LD (nn),SP
+    case 0xC2:  // JP cc,nn
+    case 0xCA:
+    case 0xD2:
+    case 0xDA:
+    case 0xC3:  // JP nn
+    case 0xC4:  // CALL cc,nn
+    case 0xCC:
+    case 0xD4:
+    case 0xDC:
+    case 0xCD:  // CALL nn
+    case 0xEA:  // LD (nn),A
+    case 0xFA:  // LD A,(nn)
+      return 3;
+    case 0x06:  // LD r,n
+    case 0x0E:
+    case 0x16:
+    case 0x1E:
+    case 0x26:
+    case 0x2E:
+    case 0x36:
+    case 0x3E:
+    case 0x18:  // JR n
+    case 0x20:  // JR cc,n
+    case 0x28:
+    case 0x30:
+    case 0x38:
+    case 0xC6:  // ALU A,n
+    case 0xCE:
+    case 0xD6:
+    case 0xDE:
+    case 0xE6:
+    case 0xEE:
+    case 0xF6:
+    case 0xFE:
+    case 0xE0:  // LDH (n),A
+    case 0xF0:  // LDH A,(n)
+    case 0xE8:  // ADD SP,n
+    case 0xF8:  // LD HL,SP+n
+    case 0xCB:  // Prefix
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+// M-cycles taken by a 'straight' instruction, operand fetches included
+[[nodiscard]] constexpr auto instruction_cycles(uint8_t opcode,
+                                                uint8_t cb_arg) -> uint8_t {
+  switch (opcode) {
+    case 0x08:  // LD (nn),SP
+      return 5;
+    case 0xC5:  // PUSH rr
+    case 0xD5:
+    case 0xE5:
+    case 0xF5:
+    case 0xE8:  // ADD SP,n
+    case 0xEA:  // LD (nn),A
+    case 0xFA:  // LD A,(nn)
+      return 4;
+    case 0x01:  // LD rr,nn
+    case 0x11:
+    case 0x21:
+    case 0x31:
+    case 0x34:  // INC (HL)
+    case 0x35:  // DEC (HL)
+    case 0x36:  // LD (HL),n
+    case 0xC1:  // POP rr
+    case 0xD1:
+    case 0xE1:
+    case 0xF1:
+    case 0xE0:  // LDH (n),A
+    case 0xF0:  // LDH A,(n)
+    case 0xF8:  // LD HL,SP+n
+      return 3;
+    case 0xCB:
+      if ((cb_arg & 0x07U) != 0x06) {
+        return 2;
+      }
+      return (cb_arg & 0xC0U) == 0x40 ? 3 : 4;  // BIT b,(HL) doesn't write
+    default:
+      break;
+  }
+  // Otherwise one cycle per fetched byte, plus one per (HL)/(rr) access or
+  // 16-Bit register operation
+  const bool accesses_memory =
+      (opcode >= 0x40 && opcode < 0xC0 &&
+       ((opcode & 0x07U) == 0x06 || (opcode & 0xF8U) == 0x70)) ||
+      (opcode < 0x40 && ((opcode & 0x07U) == 0x02 || (opcode & 0x07U) == 0x03 ||
+                         (opcode & 0x0FU) == 0x09)) ||
+      opcode == 0xE2 || opcode == 0xF2 || opcode == 0xF9;
+  return instruction_length(opcode) + (accesses_memory ? 1 : 0);
+}
+
+static_assert(instruction_cycles(0x00, 0) == 1);
+static_assert(instruction_cycles(0x3E, 0) == 2);
+static_assert(instruction_cycles(0x77, 0) == 2);
+static_assert(instruction_cycles(0x7E, 0) == 2);
+static_assert(instruction_cycles(0x86, 0) == 2);
+static_assert(instruction_cycles(0x23, 0) == 2);
+static_assert(instruction_cycles(0x29, 0) == 2);
+static_assert(instruction_cycles(0x2A, 0) == 2);
+static_assert(instruction_cycles(0xCB, 0x46) == 3);
+static_assert(instruction_cycles(0xCB, 0x86) == 4);
+
+// Instructions per block, the decode cost is paid again past this
+constexpr size_t MAX_BLOCK_INSTRUCTIONS = 32;
+// Decoded instructions kept before the whole cache is dropped
+constexpr size_t MAX_CACHED_INSTRUCTIONS = 0x10000;
+
+}  // namespace gb
@@ -6,13 +6,39 @@
 #include <algorithm>
 #include <cstdint>
 #include <format>
+#include <optional>
 
 using namespace gb;
 
-CPU::CPU(MemoryMap& memory_map, IO& io) : memory_map(&memory_map), io(&io) {}
+CPU::CPU(MemoryMap& memory_map, IO& io, ErrorPolicy& errors)
+    : memory_map(&memory_map), io(&io), errors(&errors), blocks(BLOCK_SLOTS) {}
 
 auto CPU::reset() -> void {
   registers = CPURegisters{};
+  instruction_count = 0;
+  clearBlockCache();
+}
+
+auto CPU::saveState(StateWriter& writer) const -> void {
+  writer.write(registers);
+  writer.write(comitted_registers);
+  writer.write(current_tos);
+  writer.write(return_address_pointers);
+  writer.write(expected_return_addresses);
+}
+
+auto CPU::loadState(StateReader& reader) -> void {
+  reader.read(registers);
+  reader.read(comitted_registers);
+  reader.read(current_tos);
+  reader.read(return_address_pointers);
+  reader.read(expected_return_addresses);
+
+  return_address_refcounts = {};
+  for (const auto pointer : return_address_pointers) {
+    return_address_refcounts[pointer]++;
+  }
+  clearBlockCache();
 }
 
 auto CPU::readU8(uint16_t addr, bool allow_undef) -> Byte {
@@ -20,7 +46,7 @@ auto CPU::readU8(uint16_t addr, bool allow_undef) -> Byte {
   io->cycle++;  // Under normal circumstances a read takes 1 cycle
   bool is_high_ram = 0xff80U <= addr && addr <= 0xfffeU;
   if (!is_high_ram && io->isInDMA()) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return DMABusConflict(
           std::format("Read of {:#06x} conflicts with a DMA access", addr));
     });
@@ -28,13 +54,13 @@ auto CPU::readU8(uint16_t addr, bool allow_undef) -> Byte {
 
   Byte result = memory_map->read(addr);
   if (not allow_undef && result.flags.undefined) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return UndefinedDataError(
           std::format("Read of {:#06x} returned undefined memory", addr));
     });
   }
-  if (std::ranges::contains(return_address_pointers, addr)) {
-    throw_error([&] {
+  if (return_address_refcounts[addr] != 0) {
+    report_error(*errors, [&] {
       return ReadingReturnAddressError(std::format(
           "Attempting to read a stack address corresponding to the return "
           "pointer @ {:#06x}",
@@ -50,14 +76,14 @@ auto CPU::readU16(uint16_t addr, bool allow_partial_undef) -> Word {
                  readU8(addr, allow_partial_undef)};
   if (allow_partial_undef) {
     if (result.low_undefined && result.high_undefined) {
-      throw_error([&] {
+      report_error(*errors, [&] {
         return UndefinedDataError(
             std::format("Read of {:#06x} returned undefined memory", addr));
       });
     }
   } else {
     if (result.flags.undefined) {
-      throw_error([&] {
+      report_error(*errors, [&] {
         return UndefinedDataError(
             std::format("Read of {:#06x} returned undefined memory", addr));
       });
@@ -71,18 +97,18 @@ auto CPU::writeU8(uint16_t addr, Byte value, bool allow_undef) -> void {
   io->cycle++;  // Under normal circumstances a write takes 1 cycle
   bool is_high_ram = 0xff80U <= addr && addr <= 0xfffeU;
   if (!is_high_ram && io->isInDMA()) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return DMABusConflict(
           std::format("Write of {:#06x} conflicts with a DMA access", addr));
     });
   }
   if (not allow_undef && value.flags.undefined) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return UndefinedDataError("Attempting to write undefined into memory");
     });
   }
-  if (std::ranges::contains(return_address_pointers, addr)) {
-    throw_error([&] {
+  if (return_address_refcounts[addr] != 0) {
+    report_error(*errors, [&] {
       return ClobberedReturnAddressError(std::format(
           "Attempting to clobber a stack address corresponding to the return "
           "pointer @ {:#06x}",
@@ -90,6 +116,20 @@ auto CPU::writeU8(uint16_t addr, Byte value, bool allow_undef) -> void {
     });
   }
   memory_map->write(addr, value);
+
+  if (0xFF80 <= addr && addr <= 0xFFFE) {
+    if (high_ram_code[addr - 0xFF80]) {
+      // Self-modifying code is rare, drop every high RAM block
+      for (size_t slot = 0x8000; slot < BLOCK_SLOTS; slot++) {
+        blocks[slot].valid = false;
+      }
+      high_ram_code.reset();
+      block_break = true;
+    }
+  } else if (addr <= 0x7FFF || addr >= 0xFF00) {
+    // Bank switches, IO registers (which can reschedule IO events) and IE
+    block_break = true;
+  }
 }
 
 auto CPU::writeU16(uint16_t addr, Word value, bool allow_partial_undef)
@@ -97,13 +137,13 @@ auto CPU::writeU16(uint16_t addr, Word value, bool allow_partial_undef)
   // Writes a 16-Bit LE value to 'addr'
   if (allow_partial_undef) {
     if (value.low_undefined && value.high_undefined) {
-      throw_error([&] {
+      report_error(*errors, [&] {
         return UndefinedDataError("Attempting to write undefined into memory");
       });
     }
   } else {
     if (value.flags.undefined) {
-      throw_error([&] {
+      report_error(*errors, [&] {
         return UndefinedDataError("Attempting to write undefined into memory");
       });
     }
@@ -112,18 +152,49 @@ auto CPU::writeU16(uint16_t addr, Word value, bool allow_partial_undef)
   writeU8(addr + 1, value.upper(), allow_partial_undef);
 }
 
-auto CPU::advancePC1Byte() -> uint8_t {
-  // Returns the 8-Bit value pointed to by the program counter, increments the
-  // counter
-  return readU8(registers.incrementPC()).decay();
+auto CPU::setPC(uint16_t value) -> void {
+  if (not is_valid_pc(value)) {
+    report_error(*errors, [&] {
+      return PCOutsideProgramMemory(
+          std::format("Attempting to assign {:#06x} to PC (currently {:#06x})",
+                      value, registers.pc));
+    });
+  }
+  registers.setPC(value);
+}
+
+auto CPU::incrementPC() -> uint16_t {
+  auto old_pc = registers.pc;
+  setPC(registers.pc + 1);
+  return old_pc;
+}
+
+auto CPU::pushReturnAddress(uint16_t sp) -> void {
+  // NOTE: the stack pointer points to return addr with no offset
+  expected_return_addresses.push_back(registers.pc);
+  for (const uint16_t pointer : {(uint16_t)(sp + 1), sp}) {
+    return_address_pointers.push_back(pointer);
+    return_address_refcounts[pointer]++;
+  }
+}
+
+auto CPU::popReturnAddressPointer() -> uint16_t {
+  // Nothing is tracked after the sanitizer gave up, pretend it was 0
+  if (return_address_pointers.empty()) {
+    return 0;
+  }
+  const uint16_t pointer = return_address_pointers.back();
+  return_address_pointers.pop_back();
+  return_address_refcounts[pointer]--;
+  return pointer;
 }
 
-auto CPU::advancePC2Bytes() -> uint16_t {
-  // Returns the 16-Bit value pointed to by the program counter, increments the
-  // counter twice
-  Word result = readU16(registers.pc);
-  registers.setPC(registers.pc + 2);
-  return result.decay();
+auto CPU::clearReturnAddresses() -> void {
+  for (const auto pointer : return_address_pointers) {
+    return_address_refcounts[pointer]--;
+  }
+  return_address_pointers.clear();
+  expected_return_addresses.clear();
 }
 
 auto CPU::handleInterrupts() -> void {
@@ -137,8 +208,10 @@ auto CPU::handleInterrupts() -> void {
       3       Serial              0x58
       4       P10-P13 -> Low      0x60
   */
-  uint8_t triggered =
-      (memory_map->read(0xFFFF) & memory_map->read(0xFF0F) & 0x1F_B).decay();
+  // Checked before every instruction, so skip the memory map
+  uint8_t triggered = (memory_map->interruptEnable() &
+                       Byte{io->interruptFlags()} & 0x1F_B)
+                          .decay();
 
   if (triggered != 0) {
     // Interrupt has been triggered, halt should immediately terminate
@@ -161,23 +234,149 @@ auto CPU::handleInterrupts() -> void {
   }
 }
 
-auto CPU::clock() -> void {
+auto CPU::idleTarget() const -> uint64_t {
+  /*
+  Returns the cycle idle time can be skipped to. Interrupts are only raised by
+  IO updates (or by instructions) so nothing the CPU waits on changes before
+  the next scheduled event.
+  */
+  return std::min(io->nextUpdateCycle(), idle_until);
+}
+
+auto CPU::skipPollingLoop() -> void {
+  /*
+  Called after a JR jumps back 6 bytes. Skips whole iterations of a busy-wait
+  on LY or STAT:
+      loop: LDH A,(0x44)  /  LDH A,(0x41)
+            CP n          /  AND n
+            JR NZ,loop    /  JR Z,loop
+  Both registers only change on an IO update, until then every iteration
+  reads the same value and leaves the same registers behind. Pending
+  interrupts would be taken between iterations, those loops are left alone.
+  */
+  constexpr uint64_t ITERATION_CYCLES = 3 + 2 + 3;
+
+  const uint16_t pc = registers.pc;
+  if (idle_until <= io->cycle || pc > 0x7FFA || (pc & 0xFFU) > 0xFA ||
+      io->isInDMA()) {
+    return;
+  }
+  const uint8_t* loop = memory_map->romData(pc);
+  if (loop == nullptr || loop[0] != 0xF0 || (loop[4] & 0xF7U) != 0x20 ||
+      loop[5] != 0xFA) {
+    return;
+  }
+  const bool polls_ly = loop[1] == 0x44 && loop[2] == 0xFE;
+  const bool polls_stat = loop[1] == 0x41 && loop[2] == 0xE6;
+  const uint8_t pending = (memory_map->interruptEnable() &
+                           Byte{io->interruptFlags()} & 0x1F_B)
+                              .decay();
+  if (not(polls_ly || polls_stat) || pending != 0) {
+    return;
+  }
+
+  if (const uint64_t target = idleTarget(); target > io->cycle) {
+    const uint64_t iterations = (target - io->cycle) / ITERATION_CYCLES;
+    io->cycle += iterations * ITERATION_CYCLES;
+    instruction_count += 3 * iterations;
+  }
+}
+
+auto CPU::clock(uint64_t idle_until) -> void {
+  this->idle_until = idle_until;
+
   // Check for interrupts (if enabled)
   handleInterrupts();
 
   // Do nothing if waiting for interrupt
   if (registers.halt) {
-    io->cycle++;  // Some time should pass to allow timers to trigger
+    // Some time should pass to allow timers to trigger. Nothing can wake the
+    // CPU before the next IO update, so skip straight to it if allowed.
+    io->cycle = std::max(io->cycle + 1, idleTarget());
     return;
   }
 
   // Advance the program counter
   processNextInstruction();
-  registers.IME[0] = registers.IME[1];
-  registers.IME[1] = registers.IME[2];
+}
+
+auto CPU::decodeBlock(uint16_t pc, const uint8_t* source) -> CachedBlock {
+  /*
+  Decodes instructions from 'pc' until one ends the block. A ROM block stays
+  inside its 16KiB region, controllers always switch a whole region so the
+  bank of the first byte is the bank of every byte. The sanitizer checks of a
+  fetch are made here, high RAM that would fail them isn't cached.
+  */
+  if (cached_instructions.size() + MAX_BLOCK_INSTRUCTIONS >
+      MAX_CACHED_INSTRUCTIONS) {
+    clearBlockCache();
+  }
+
+  CachedBlock block{.source = source,
+                    .first = (uint32_t)cached_instructions.size(),
+                    .cycles = 0,
+                    .count = 0,
+                    .valid = true};
+  const size_t region_end = pc <= 0x7FFF ? (pc & 0xC000U) + 0x4000U : 0xFFFF;
+  auto fetch = [&](size_t addr) -> std::optional<uint8_t> {
+    if (addr >= region_end || return_address_refcounts[addr] != 0) {
+      return std::nullopt;
+    }
+    if (source != nullptr) {
+      const uint8_t* rom = memory_map->romData(addr);
+      if (rom != source + (addr - pc)) {
+        return std::nullopt;
+      }
+      return *rom;
+    }
+    const Byte value = memory_map->read(addr);
+    if (value.flags.undefined) {
+      return std::nullopt;
+    }
+    return value.decay();
+  };
+
+  size_t addr = pc;
+  uint8_t previous_cycles = 0;
+  while (block.count < MAX_BLOCK_INSTRUCTIONS) {
+    const auto opcode = fetch(addr);
+    if (not opcode || block_role(*opcode) == BlockRole::not_cached) {
+      break;
+    }
+    CachedInstruction instruction{.handler = opcodeHandlers[*opcode],
+                                  .bytes = {*opcode, 0, 0}};
+    const uint8_t length = instruction_length(*opcode);
+    bool is_complete = true;
+    for (uint8_t i = 1; i < length; i++) {
+      const auto operand = fetch(addr + i);
+      is_complete = is_complete && operand.has_value();
+      instruction.bytes[i] = operand.value_or(0);
+    }
+    if (not is_complete) {
+      break;
+    }
+
+    if (source == nullptr) {
+      for (uint8_t i = 0; i < length; i++) {
+        high_ram_code.set(addr + i - 0xFF80);
+      }
+    }
+    cached_instructions.push_back(instruction);
+    block.cycles += previous_cycles;
+    block.count++;
+    if (block_role(*opcode) == BlockRole::ends_block) {
+      break;
+    }
+    previous_cycles = instruction_cycles(*opcode, instruction.bytes[1]);
+    addr += length;
+  }
+  return block;
+}
 
-  // Instruction was successful, commit registers for easier debugging
-  comitted_registers = registers;
+auto CPU::clearBlockCache() -> void {
+  std::ranges::fill(blocks, CachedBlock{});
+  cached_instructions.clear();
+  high_ram_code.reset();
 }
 
 auto CPU::getCurrentRegisters() -> CPURegisters& {
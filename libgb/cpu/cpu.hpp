@@ -1,10 +1,15 @@
 #pragma once
 
 #include <sys/types.h>
+#include "../error_handling.hpp"
 #include "../memory_map.hpp"
 #include "../utils/checked_int.hpp"
+#include "../utils/save_state.hpp"
+#include "block_cache.hpp"
 #include "registers.hpp"
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <optional>
 #include <vector>
@@ -38,6 +43,7 @@ class CPU {
   CPURegisters comitted_registers;
   MemoryMap* memory_map;
   IO* io;
+  ErrorPolicy* errors;
 
   // State required for control flow sanitation
   std::optional<uint16_t> current_tos = 0;
@@ -46,14 +52,32 @@ class CPU {
   std::vector<uint16_t> return_address_pointers = {};
   std::vector<uint16_t> expected_return_addresses = {};
 
+  // How many tracked return addresses cover each address, so checking a memory
+  // access doesn't depend on the call depth. Derived from
+  // 'return_address_pointers', it is not part of the save state.
+  std::array<uint16_t, 0x10000> return_address_refcounts = {};
+
+  // Host bytes of the current instruction when it is fetched straight from ROM
+  const uint8_t* rom_fetch = nullptr;
+
+  // Halts and polling loops may be skipped up to this cycle, 0 never skips
+  uint64_t idle_until = 0;
+
+  // Instructions run since reset (skipped polling loops included), statistics
+  // only so it is not part of the save state
+  uint64_t instruction_count = 0;
+
  public:
-  CPU(MemoryMap& memory_map, IO& io);
+  CPU(MemoryMap& memory_map, IO& io, ErrorPolicy& errors);
   CPU(const CPU&) = delete;
   auto operator=(const CPU&) -> CPU& = delete;
   ~CPU() = default;
 
   auto reset() -> void;
 
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
+
   // Reads cannot be const since they consume 1 cycle
   [[nodiscard]] auto readU8(uint16_t addr, bool allow_undef = false) -> Byte;
   [[nodiscard]] auto readU16(uint16_t addr, bool allow_partial_undef = false)
@@ -63,7 +87,12 @@ class CPU {
   auto writeU16(uint16_t addr, Word value, bool allow_partial_undef = false)
       -> void;
 
-  auto clock() -> void;
+  // Idle time is only skipped if 'idle_until' is given, single steps are exact
+  auto clock(uint64_t idle_until = 0) -> void;
+
+  [[nodiscard]] auto instructionCount() const -> uint64_t {
+    return instruction_count;
+  }
 
   // Debug
   auto getCurrentRegisters() -> CPURegisters&;
@@ -71,29 +100,79 @@ class CPU {
   auto insertInterruptOnNextCycle(uint8_t id) -> void;
 
  private:
+  // Sanitized writes to the program counter
+  auto setPC(uint16_t value) -> void;
+  auto incrementPC() -> uint16_t;
+
   [[nodiscard]] auto advancePC1Byte() -> uint8_t;
   [[nodiscard]] auto advancePC2Bytes() -> uint16_t;
   auto handleInterrupts() -> void;
-  auto processNextInstruction() -> void;
+  [[nodiscard]] auto idleTarget() const -> uint64_t;
+  auto skipPollingLoop() -> void;
 
-  // Helper function for the _ptr registers
-  auto getRegU8(Register) -> Byte;
-  auto setRegU8(Register, Byte) -> void;
-  auto getRegU16(Register) -> Word;
-  auto setRegU16(Register, Word) -> void;
+  auto pushReturnAddress(uint16_t sp) -> void;
+  auto popReturnAddressPointer() -> uint16_t;
+  auto clearReturnAddresses() -> void;
+  auto processNextInstruction() -> void;
+  auto stepInstruction() -> void;
+  auto retireInstruction() -> void;
+
+  // Opcode handlers, instantiated once per opcode (see opcodes.cpp)
+  using OpcodeHandler = auto (CPU::*)() -> void;
+  static const std::array<OpcodeHandler, 0x100> opcodeHandlers;
+  static const std::array<OpcodeHandler, 0x100> cbOpcodeHandlers;
+
+  // Decoded instruction, run by pointing 'rom_fetch' at its bytes
+  struct CachedInstruction {
+    OpcodeHandler handler;
+    std::array<uint8_t, 3> bytes;
+  };
+
+  // Decoded run of instructions (see block_cache.hpp). The cache isn't part
+  // of the save state, it is dropped whenever memory is replaced.
+  struct CachedBlock {
+    // ROM the block was decoded from, so a different bank at the same PC is a
+    // miss. Null in high RAM, where writes invalidate the block instead.
+    const uint8_t* source = nullptr;
+    uint32_t first = 0;   // Index of the first instruction
+    uint16_t cycles = 0;  // Taken before the last instruction starts
+    uint8_t count = 0;    // 0 if the instruction at PC can't be cached
+    bool valid = false;
+  };
+
+  // One block per ROM and high RAM address
+  static constexpr size_t BLOCK_SLOTS = 0x8000 + 0x80;
+  std::vector<CachedBlock> blocks;
+  std::vector<CachedInstruction> cached_instructions;
+  std::bitset<0x80> high_ram_code;  // High RAM decoded into any block
+  // Set by writes that can change the code or the next IO event
+  bool block_break = false;
+
+  [[nodiscard]] auto findBlock() -> const CachedBlock*;
+  [[nodiscard]] auto decodeBlock(uint16_t pc, const uint8_t* source)
+      -> CachedBlock;
+  auto clearBlockCache() -> void;
+  auto executeCached(const CachedInstruction& instruction) -> void;
+
+  template <uint8_t opcode>
+  auto executeOpcode() -> void;
+  template <uint8_t opcode>
+  auto executeCBOpcode() -> void;
+
+  // Helper function for the _ptr registers, resolved at compile time
+  template <Register reg>
+  auto getRegU8() -> Byte;
+  template <Register reg>
+  auto setRegU8(Byte) -> void;
+  template <Register reg>
+  auto getRegU16() -> Word;
+  template <Register reg>
+  auto setRegU16(Word) -> void;
 
   // 8-Bit loads
-  // LD r, n
-  void LD_r_n(Register r, uint8_t n);
+  // LD r, n / LD r1, r2 / LD n, A are plain register moves, see opcodes.cpp
 
-  // LD r, (nn)
-  void LD_r_nn(Register r, uint16_t nn);
-
-  // LD r1, r1
-  void LD_r1_r2(Register r1, Register r2);
-
-  // LD n, A
-  void LD_r_A(Register r);
+  // LD (nn), A
   void LD_nn_A(uint16_t addr);
 
   // LD A,(C)
@@ -121,9 +200,6 @@ class CPU {
   void LDH_A_n(uint8_t n);
 
   // 16-Bit loads
-  // LD n,nn
-  void LD16_n_nn(Register n, uint16_t nn);
-
   // LD SP,HL
   void LD16_SP_HL();
 
@@ -134,10 +210,10 @@ class CPU {
   void LD_nn_SP(uint16_t nn);
 
   // PUSH nn
-  void PUSH(Register r);
+  void PUSH(Word nn);
 
   // POP nn
-  void POP(Register r);
+  auto POP() -> Word;
 
   // 8-Bit ALU
   // ADD n
@@ -165,10 +241,10 @@ class CPU {
   void CP_n(Byte n);
 
   // INC n
-  void INC_r(Register r);
+  auto INC_r(Byte value) -> Byte;
 
   // DEC n
-  void DEC_r(Register r);
+  auto DEC_r(Byte value) -> Byte;
 
   // 16-Bit ALU
   // Helper function for 16-Bit addition
@@ -176,20 +252,20 @@ class CPU {
   auto ADD16_SIGN(Word nn, Byte n, bool derived_from_sp) -> Word;
 
   // ADD HL,n
-  void ADD16_HL_n(Register n);
+  void ADD16_HL_n(Word n);
 
   // ADD SP,n
   void ADD16_SP_n(int8_t n);
 
   // INC nn
-  void INC16_nn(Register nn);
+  auto INC16_nn(Word nn) -> Word;
 
   // DEC nn
-  void DEC16_nn(Register nn);
+  auto DEC16_nn(Word nn) -> Word;
 
   // Miscellaneous
   // SWAP n
-  void SWAP_n(Register n);
+  auto SWAP_n(Byte n) -> Byte;
 
   // DAA
   void DAA();
@@ -227,39 +303,39 @@ class CPU {
   auto ROT_R(Byte value) -> Byte;
 
   // RLC n
-  void RLCA();             // RLCA
-  void RLC_r(Register r);  // RLC r
+  void RLCA();                 // RLCA
+  auto RLC_r(Byte r) -> Byte;  // RLC r
 
   // RL n
-  void RLA();             // RLA
-  void RL_r(Register r);  // RL r
+  void RLA();                 // RLA
+  auto RL_r(Byte r) -> Byte;  // RL r
 
   // RRC n
-  void RRCA();             // RRCA
-  void RRC_r(Register r);  // RRC r
+  void RRCA();                 // RRCA
+  auto RRC_r(Byte r) -> Byte;  // RRC r
 
   // RR n
-  void RRA();             // RRA
-  void RR_r(Register r);  // RR r
+  void RRA();                 // RRA
+  auto RR_r(Byte r) -> Byte;  // RR r
 
   // SLA n
-  void SLA_n(Register r);
+  auto SLA_n(Byte r) -> Byte;
 
   // SRA n
-  void SRA_n(Register r);
+  auto SRA_n(Byte r) -> Byte;
 
   // SRL n
-  void SRL_n(Register r);
+  auto SRL_n(Byte r) -> Byte;
 
   // Bit stuff
   // BIT b,r
-  void BIT_b_r(uint8_t b, Register r);
+  void BIT_b_r(uint8_t b, Byte r);
 
   // SET b,r
-  void SET_b_r(uint8_t b, Register r);
+  auto SET_b_r(uint8_t b, Byte r) -> Byte;
 
   // RES b,r
-  void RES_b_r(uint8_t b, Register r);
+  auto RES_b_r(uint8_t b, Byte r) -> Byte;
 
   // Jumps
   // JP nn
@@ -6,148 +6,9 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
-#include <stdexcept>
 
 using namespace gb;
 
-auto CPU::getRegU8(Register reg) -> Byte {
-  switch (reg) {
-    case Register::A:
-      return registers.getU8(Reg8::A);
-    case Register::F:
-      return registers.getU8(Reg8::F);
-    case Register::B:
-      return registers.getU8(Reg8::B);
-    case Register::C:
-      return registers.getU8(Reg8::C);
-    case Register::D:
-      return registers.getU8(Reg8::D);
-    case Register::E:
-      return registers.getU8(Reg8::E);
-    case Register::H:
-      return registers.getU8(Reg8::H);
-    case Register::L:
-      return registers.getU8(Reg8::L);
-    case Register::HL_ptr:
-      return readU8(registers.getU16(Reg16::HL).decay());
-    case Register::BC_ptr:
-      return readU8(registers.getU16(Reg16::BC).decay());
-    case Register::DE_ptr:
-      return readU8(registers.getU16(Reg16::DE).decay());
-    default:
-      throw std::runtime_error("Register cannot be converted to u8");
-  }
-}
-
-auto CPU::setRegU8(Register reg, Byte value) -> void {
-  switch (reg) {
-    case Register::A:
-      return registers.setU8(Reg8::A, value);
-    case Register::F:
-      return registers.setU8(Reg8::F, value);
-    case Register::B:
-      return registers.setU8(Reg8::B, value);
-    case Register::C:
-      return registers.setU8(Reg8::C, value);
-    case Register::D:
-      return registers.setU8(Reg8::D, value);
-    case Register::E:
-      return registers.setU8(Reg8::E, value);
-    case Register::H:
-      return registers.setU8(Reg8::H, value);
-    case Register::L:
-      return registers.setU8(Reg8::L, value);
-    case Register::HL_ptr:
-      return writeU8(registers.getU16(Reg16::HL).decay(), value);
-    case Register::BC_ptr:
-      return writeU8(registers.getU16(Reg16::BC).decay(), value);
-    case Register::DE_ptr:
-      return writeU8(registers.getU16(Reg16::DE).decay(), value);
-    default:
-      throw std::runtime_error("Register cannot be converted to u8");
-  }
-}
-
-auto CPU::getRegU16(Register reg) -> Word {
-  switch (reg) {
-    case Register::AF:
-      return registers.getU16(Reg16::AF);
-    case Register::HL:
-      return registers.getU16(Reg16::HL);
-    case Register::BC:
-      return registers.getU16(Reg16::BC);
-    case Register::DE:
-      return registers.getU16(Reg16::DE);
-    case Register::SP:
-      return registers.getU16(Reg16::SP);
-    case Register::PC:
-      return registers.getU16(Reg16::PC);
-    default:
-      throw std::runtime_error("Register cannot be converted to u16");
-  }
-}
-
-auto CPU::setRegU16(Register reg, Word value) -> void {
-  switch (reg) {
-    case Register::AF:
-      return registers.setU16(Reg16::AF, value);
-    case Register::HL:
-      return registers.setU16(Reg16::HL, value);
-    case Register::BC:
-      return registers.setU16(Reg16::BC, value);
-    case Register::DE:
-      return registers.setU16(Reg16::DE, value);
-    case Register::SP:
-      return registers.setU16(Reg16::SP, value);
-    case Register::PC:
-      return registers.setU16(Reg16::PC, value);
-    default:
-      throw std::runtime_error("Register cannot be converted to u16");
-  }
-}
-
-void CPU::LD_r_n(Register r, uint8_t n) {
-  /*
-  Description:
-      Put value n into r.
-  Use with:
-      n = B,C,D,E,H,L
-      nn = 8 bit immediate value
-  */
-  setRegU8(r, Byte{n});
-}
-
-void CPU::LD_r_nn(Register r, uint16_t nn) {
-  /*
-  Description:
-      Put value nn into r.
-  Use with:
-      r = A,B,C,D,E,H,L,(HL)
-      nn = 16 bit immediate value
-  */
-  setRegU8(r, readU8(nn));
-}
-
-void CPU::LD_r1_r2(Register r1, Register r2) {
-  /*
-  Description:
-      Put value r2 into r1.
-  Use with:
-      r1 = A,B,C,D,E,H,L,(HL)
-      r2 = A,B,C,D,E,H,L,(HL),n
-  */
-  setRegU8(r1, getRegU8(r2));
-}
-
-void CPU::LD_r_A(Register r) {
-  /*
-  Description:
-      Put value A into n (registers).
-  Use with:
-      n = A,B,C,D,E,H,L
-  */
-  setRegU8(r, registers.a);
-}
 void CPU::LD_nn_A(uint16_t addr) {
   /*
   Description:
@@ -184,10 +45,10 @@ void CPU::LDD_A_HL() {
   Same as:
       LD A,(HL) - DEC HL
   */
-  Word hl = getRegU16(Register::HL);
+  Word hl = registers.getU16(Reg16::HL);
   registers.a = readU8(hl.decay());
   // Don't use DEC16 here. Its free
-  setRegU16(Register::HL, hl - 1_W);
+  registers.setU16(Reg16::HL, hl - 1_W);
 }
 
 void CPU::LDD_HL_A() {
@@ -197,10 +58,10 @@ void CPU::LDD_HL_A() {
   Same as:
       LD (HL),A - DEC HL
   */
-  Word hl = getRegU16(Register::HL);
+  Word hl = registers.getU16(Reg16::HL);
   writeU8(hl.decay(), registers.a);
   // Don't use DEC16 here. Its free
-  setRegU16(Register::HL, hl - 1_W);
+  registers.setU16(Reg16::HL, hl - 1_W);
 }
 
 void CPU::LDI_A_HL() {
@@ -210,10 +71,10 @@ void CPU::LDI_A_HL() {
   Same as:
       LD A,(HL) - INC HL
   */
-  Word hl = getRegU16(Register::HL);
+  Word hl = registers.getU16(Reg16::HL);
   registers.a = readU8(hl.decay());
   // Don't use INC16 here. Its free
-  setRegU16(Register::HL, hl + 1_W);
+  registers.setU16(Reg16::HL, hl + 1_W);
 }
 
 void CPU::LDI_HL_A() {
@@ -223,10 +84,10 @@ void CPU::LDI_HL_A() {
   Same as:
       LD (HL),A - INC HL
   */
-  Word hl = getRegU16(Register::HL);
+  Word hl = registers.getU16(Reg16::HL);
   writeU8(hl.decay(), registers.a);
   // Don't use INC16 here. Its free
-  setRegU16(Register::HL, hl + 1_W);
+  registers.setU16(Reg16::HL, hl + 1_W);
 }
 
 void CPU::LDH_n_A(uint8_t n) {
@@ -249,23 +110,13 @@ void CPU::LDH_A_n(uint8_t n) {
   registers.a = readU8(0xFF00U | n);
 }
 
-void CPU::LD16_n_nn(Register n, uint16_t nn) {
-  /*
-  Description:
-      Put value nn into n.
-  Use with:
-      n = BC,DE,HL,SP  nn = 16 bit immediate value
-  */
-  setRegU16(n, Word{nn});
-}
-
 void CPU::LD16_SP_HL() {
   /*
   Description:
       Put HL into Stack Pointer (SP)
   */
   io->cycle++;  // 16-Bit load takes an extra cycle
-  registers.sp = getRegU16(Register::HL).decay();
+  registers.sp = registers.getU16(Reg16::HL).decay();
 }
 
 void CPU::LDHL_SP_n(int8_t n) {
@@ -280,8 +131,9 @@ void CPU::LDHL_SP_n(int8_t n) {
       H - Set or reset according to operation.
       C - Set or reset according to operation.
   */
-  setRegU16(Register::HL,
-            ADD16_SIGN(registers.getU16(Reg16::SP), Byte{(uint8_t)n}, true));
+  registers.setU16(
+      Reg16::HL,
+      ADD16_SIGN(registers.getU16(Reg16::SP), Byte{(uint8_t)n}, true));
 }
 
 void CPU::LD_nn_SP(uint16_t nn) {
@@ -294,7 +146,7 @@ void CPU::LD_nn_SP(uint16_t nn) {
   writeU16(nn, registers.getU16(Reg16::SP));
 }
 
-void CPU::PUSH(Register r) {
+void CPU::PUSH(Word nn) {
   /*
   Description:
       Push register pair nn onto stack.
@@ -304,10 +156,10 @@ void CPU::PUSH(Register r) {
   */
   io->cycle++;  // PUSH takes extra cycle -- 16-Bit read?
   registers.sp -= 2;
-  writeU16(registers.sp, getRegU16(r), /*allow_partial_undef=*/true);
+  writeU16(registers.sp, nn, /*allow_partial_undef=*/true);
 }
 
-void CPU::POP(Register r) {
+auto CPU::POP() -> Word {
   /*
   Description:
       Pop two bytes off stack into register pair nn.
@@ -315,8 +167,9 @@ void CPU::POP(Register r) {
   Use with:
       nn = AF,BC,DE,HL
   */
-  setRegU16(r, readU16(registers.sp, /*allow_partial_undef=*/true));
+  Word result = readU16(registers.sp, /*allow_partial_undef=*/true);
   registers.sp += 2;
+  return result;
 }
 
 void CPU::ADD_n(Byte n, bool carry) {
@@ -470,7 +323,7 @@ void CPU::CP_n(Byte n) {
   registers.setFlags(Flag::C, registers.a < n);
 }
 
-void CPU::INC_r(Register r) {
+auto CPU::INC_r(Byte value) -> Byte {
   /*
   Description:
       Increment register n.
@@ -482,14 +335,14 @@ void CPU::INC_r(Register r) {
       H - Set if carry from bit 3.
       C - Not affected.
   */
-  Byte result = getRegU8(r) + 1_B;
-  setRegU8(r, result);
+  Byte result = value + 1_B;
   registers.setFlags(Flag::Z, result == 0_B);
   registers.setFlags(Flag::H, (result & 0x0F_B) == 0_B);
   registers.resetFlags(Flag::N);
+  return result;
 }
 
-void CPU::DEC_r(Register r) {
+auto CPU::DEC_r(Byte value) -> Byte {
   /*
   Description:
       Decrement register n.
@@ -502,11 +355,11 @@ void CPU::DEC_r(Register r) {
       C - Not affected.
   */
   // TODO: Set if no borrow from bit 4.
-  Byte result = getRegU8(r) - 1_B;
-  setRegU8(r, result);
+  Byte result = value - 1_B;
   registers.setFlags(Flag::Z, result == 0_B);
   registers.setFlags(Flag::H, (result & 0x0F_B) == 0x0F_B);
   registers.setFlags(Flag::N);
+  return result;
 }
 
 auto CPU::ADD16(Word n1, Word n2) -> Word {
@@ -549,7 +402,7 @@ auto CPU::ADD16_SIGN(Word nn, Byte n, bool derived_from_sp) -> Word {
               {.derived_from_sp = derived_from_sp, .undefined = false});
 }
 
-void CPU::ADD16_HL_n(Register n) {
+void CPU::ADD16_HL_n(Word n) {
   /*
   Description:
       Add n to HL.
@@ -561,9 +414,8 @@ void CPU::ADD16_HL_n(Register n) {
       H - Set if carry from bit 11.
       C - Set if carry from bit 15.
   */
-  Word hl_val = getRegU16(Register::HL);
-  Word n_val = getRegU16(n);
-  setRegU16(Register::HL, ADD16(hl_val, n_val));
+  Word hl_val = registers.getU16(Reg16::HL);
+  registers.setU16(Reg16::HL, ADD16(hl_val, n));
 }
 
 void CPU::ADD16_SP_n(int8_t n) {
@@ -583,7 +435,7 @@ void CPU::ADD16_SP_n(int8_t n) {
       ADD16_SIGN(registers.getU16(Reg16::SP), Byte{(uint8_t)n}, true).decay();
 }
 
-void CPU::INC16_nn(Register nn) {
+auto CPU::INC16_nn(Word nn) -> Word {
   /*
   Description:
       Increment register nn.
@@ -593,10 +445,10 @@ void CPU::INC16_nn(Register nn) {
       None
   */
   io->cycle++;
-  setRegU16(nn, getRegU16(nn) + 1_W);
+  return nn + 1_W;
 }
 
-void CPU::DEC16_nn(Register nn) {
+auto CPU::DEC16_nn(Word nn) -> Word {
   /*
   Description:
       Decrement register nn.
@@ -606,10 +458,10 @@ void CPU::DEC16_nn(Register nn) {
       None
   */
   io->cycle++;
-  setRegU16(nn, getRegU16(nn) - 1_W);
+  return nn - 1_W;
 }
 
-void CPU::SWAP_n(Register n) {
+auto CPU::SWAP_n(Byte value) -> Byte {
   /*
   Description:
       Swap upper & lower nibles of n.
@@ -621,10 +473,9 @@ void CPU::SWAP_n(Register n) {
       H - Reset.
       C - Reset
   */
-  Byte value = getRegU8(n);
   registers.setFlags(Flag::Z, value == 0_B);
   registers.resetFlags(Flag::N | Flag::H | Flag::C);
-  setRegU8(n, ((value & 0x0F_B) << 4U) | ((value & 0xF0_B) >> 4U));
+  return ((value & 0x0F_B) << 4U) | ((value & 0xF0_B) >> 4U);
 }
 
 void CPU::DAA() {
@@ -879,7 +730,7 @@ void CPU::RRA() {
   registers.a = ROT_R(registers.a);
 }
 
-void CPU::RLC_r(Register r) {
+auto CPU::RLC_r(Byte value) -> Byte {
   /*
   Description:
       Rotate n left. Old bit 7 to Carry flag.
@@ -891,12 +742,12 @@ void CPU::RLC_r(Register r) {
       H - Reset.
       C - Contains old bit 7 data.
   */
-  Byte result = ROT_LC(getRegU8(r));
+  Byte result = ROT_LC(value);
   registers.setFlags(Flag::Z, result == 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::RL_r(Register r) {
+auto CPU::RL_r(Byte value) -> Byte {
   /*
   Description:
       Rotate n left through Carry flag.
@@ -908,12 +759,12 @@ void CPU::RL_r(Register r) {
       H - Reset.
       C - Contains old bit 7 data.
   */
-  Byte result = ROT_L(getRegU8(r));
+  Byte result = ROT_L(value);
   registers.setFlags(Flag::Z, result == 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::RRC_r(Register r) {
+auto CPU::RRC_r(Byte value) -> Byte {
   /*
   Description:
       Rotate n right. Old bit 0 to Carry flag.
@@ -925,12 +776,12 @@ void CPU::RRC_r(Register r) {
       H - Reset.
       C - Contains old bit 0 data.
   */
-  Byte result = ROT_RC(getRegU8(r));
+  Byte result = ROT_RC(value);
   registers.setFlags(Flag::Z, result == 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::RR_r(Register r) {
+auto CPU::RR_r(Byte value) -> Byte {
   /*
   Description:
       Rotate n right through Carry flag.
@@ -942,12 +793,12 @@ void CPU::RR_r(Register r) {
       H - Reset.
       C - Contains old bit 0 data.
   */
-  Byte result = ROT_R(getRegU8(r));
+  Byte result = ROT_R(value);
   registers.setFlags(Flag::Z, result == 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::SLA_n(Register r) {
+auto CPU::SLA_n(Byte value) -> Byte {
   /*
   Description:
       Shift n left into Carry. LSB of n set to 0.
@@ -959,14 +810,13 @@ void CPU::SLA_n(Register r) {
       H - Reset.
       C - Contains old bit 7 data.
   */
-  Byte value = getRegU8(r);
-  setRegU8(r, value << 1U);
   registers.resetFlags(Flag::N | Flag::H);
   registers.setFlags(Flag::Z, (value & 0x7F_B) == 0_B);
   registers.setFlags(Flag::C, (value & 0x80_B) != 0_B);
+  return value << 1U;
 }
 
-void CPU::SRA_n(Register r) {
+auto CPU::SRA_n(Byte value) -> Byte {
   /*
   Description:
       Shift n right into Carry. MSB doesn't change.
@@ -978,15 +828,14 @@ void CPU::SRA_n(Register r) {
           H - Reset.
           C - Contains old bit 0 data
   */
-  Byte value = getRegU8(r);
   Byte result = (value >> 1U) | (value & 0x80_B);
   registers.resetFlags(Flag::N | Flag::H);
   registers.setFlags(Flag::Z, result == 0_B);
   registers.setFlags(Flag::C, (value & 1_B) != 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::SRL_n(Register r) {
+auto CPU::SRL_n(Byte value) -> Byte {
   /*
   Description:
       Shift n right into Carry. MSB set to 0.
@@ -998,15 +847,14 @@ void CPU::SRL_n(Register r) {
       H - Reset.
       C - Contains old bit 0 data.
   */
-  Byte value = getRegU8(r);
   Byte result = value >> 1U;
   registers.resetFlags(Flag::N | Flag::H);
   registers.setFlags(Flag::Z, result == 0_B);
   registers.setFlags(Flag::C, (value & 1_B) != 0_B);
-  setRegU8(r, result);
+  return result;
 }
 
-void CPU::BIT_b_r(uint8_t b, Register r) {
+void CPU::BIT_b_r(uint8_t b, Byte r) {
   /*
   Description:
       Test bit b in register r.
@@ -1018,12 +866,12 @@ void CPU::BIT_b_r(uint8_t b, Register r) {
       H - Set.
       C - Not affected.
   */
-  registers.setFlags(Flag::Z, (getRegU8(r) & (1_B << b)) == 0_B);
+  registers.setFlags(Flag::Z, (r & (1_B << b)) == 0_B);
   registers.setFlags(Flag::H);
   registers.resetFlags(Flag::N);
 }
 
-void CPU::SET_b_r(uint8_t b, Register r) {
+auto CPU::SET_b_r(uint8_t b, Byte r) -> Byte {
   /*
   Description:
       Set bit b in register r.
@@ -1032,10 +880,10 @@ void CPU::SET_b_r(uint8_t b, Register r) {
   Flags affected:
       None
   */
-  setRegU8(r, getRegU8(r) | (1_B << b));
+  return r | (1_B << b);
 }
 
-void CPU::RES_b_r(uint8_t b, Register r) {
+auto CPU::RES_b_r(uint8_t b, Byte r) -> Byte {
   /*
   Description:
       Reset bit b in register r.
@@ -1044,7 +892,7 @@ void CPU::RES_b_r(uint8_t b, Register r) {
   Flags affected:
       None
   */
-  setRegU8(r, getRegU8(r) & ~(1_B << b));
+  return r & ~(1_B << b);
 }
 
 void CPU::JP_nn(uint16_t nn) {
@@ -1055,7 +903,7 @@ void CPU::JP_nn(uint16_t nn) {
       nn = two byte immediate value. (LS byte first.)
   */
   io->cycle++;  // Jumping takes 1 cycle
-  registers.setPC(nn);
+  setPC(nn);
 }
 
 void CPU::JP_cc_nn(Flag f, bool set, uint16_t nn) {
@@ -1080,7 +928,7 @@ void CPU::JP_HL() {
       Jump to address contained in HL
   */
   // Dont use JP function here since HL jump is free (0 cycles)
-  registers.setPC(getRegU16(Register::HL).decay());
+  setPC(registers.getU16(Reg16::HL).decay());
 }
 
 void CPU::JR_n(int8_t n) {
@@ -1102,6 +950,9 @@ void CPU::JR_cc_n(Flag f, bool set, int8_t n) {
   C,  Jump if C flag is set.
   */
   JP_cc_nn(f, set, registers.pc + n);
+  if (n == -6 && registers.getFlags(f) == set) {
+    skipPollingLoop();
+  }
 }
 
 void CPU::CALL_nn(uint16_t nn) {
@@ -1111,15 +962,11 @@ void CPU::CALL_nn(uint16_t nn) {
   Use with:
       nn = two byte immediate value. (LS byte first.)
   */
-  PUSH(Register::PC);
-
-  // NOTE: the stack pointer points to return addr with no offset
-  expected_return_addresses.push_back(registers.pc);
-  return_address_pointers.push_back(registers.sp + 1);
-  return_address_pointers.push_back(registers.sp);
+  PUSH(registers.getU16(Reg16::PC));
+  pushReturnAddress(registers.sp);
 
   // Don't call JP_nn, the jump should take 0 cycles
-  registers.setPC(nn);
+  setPC(nn);
 }
 
 void CPU::CALL_cc_nn(Flag f, bool set, uint16_t nn) {
@@ -1164,36 +1011,34 @@ void CPU::RET() {
     return result;
   };
 
-  uint16_t expected_sp = pop_back(return_address_pointers);
-  uint16_t expected_sp_plus_1 = pop_back(return_address_pointers);
+  uint16_t expected_sp = popReturnAddressPointer();
+  uint16_t expected_sp_plus_1 = popReturnAddressPointer();
   assert(expected_sp_plus_1 == expected_sp + 1 ||
          (expected_sp == 0 && expected_sp_plus_1 == 0));
 
   if (expected_sp != registers.sp) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return CallFrameViolationError(
           "Returning from a stack pointer that does not correspond to the last "
           "call instruction.");
     });
 
     // Information is stale. Lets just give up.
-    return_address_pointers.clear();
-    expected_return_addresses.clear();
+    clearReturnAddresses();
   }
 
   uint16_t expected_addr = pop_back(expected_return_addresses);
   uint16_t actual_addr = readU16(registers.sp).decay();
 
   if (expected_addr != actual_addr) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return ClobberedReturnAddressError(
           "Returning from the correct stack pointer but the value has been "
           "clobbered since the last call.");
     });
 
     // Information is stale. Lets just give up.
-    return_address_pointers.clear();
-    expected_return_addresses.clear();
+    clearReturnAddresses();
   }
 
   registers.sp += 2;
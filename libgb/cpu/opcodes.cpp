@@ -1,13 +1,14 @@
 #include "cpu.hpp"
 
 #include "../error_handling.hpp"
+#include "../io/io.hpp"
 #include "../utils/checked_int.hpp"
 
 #include <array>
 #include <cstdint>
 #include <format>
-
-#include <iostream>
+#include <stdexcept>
+#include <utility>
 
 using namespace gb;
 
@@ -18,8 +19,260 @@ constexpr std::array registerOpcodes = {
 constexpr std::array register16Opcodes = {Register::BC, Register::DE,
                                           Register::HL, Register::SP};
 
-auto CPU::processNextInstruction() -> void {
+// PUSH/POP encode AF where the other 16-Bit ops encode SP
+constexpr std::array register16StackOpcodes = {Register::BC, Register::DE,
+                                               Register::HL, Register::AF};
+
+template <Register reg>
+auto CPU::getRegU8() -> Byte {
+  switch (reg) {
+    case Register::A:
+      return registers.getU8(Reg8::A);
+    case Register::F:
+      return registers.getU8(Reg8::F);
+    case Register::B:
+      return registers.getU8(Reg8::B);
+    case Register::C:
+      return registers.getU8(Reg8::C);
+    case Register::D:
+      return registers.getU8(Reg8::D);
+    case Register::E:
+      return registers.getU8(Reg8::E);
+    case Register::H:
+      return registers.getU8(Reg8::H);
+    case Register::L:
+      return registers.getU8(Reg8::L);
+    case Register::HL_ptr:
+      return readU8(registers.getU16(Reg16::HL).decay());
+    case Register::BC_ptr:
+      return readU8(registers.getU16(Reg16::BC).decay());
+    case Register::DE_ptr:
+      return readU8(registers.getU16(Reg16::DE).decay());
+    default:
+      throw std::runtime_error("Register cannot be converted to u8");
+  }
+}
+
+template <Register reg>
+auto CPU::setRegU8(Byte value) -> void {
+  switch (reg) {
+    case Register::A:
+      return registers.setU8(Reg8::A, value);
+    case Register::F:
+      return registers.setU8(Reg8::F, value);
+    case Register::B:
+      return registers.setU8(Reg8::B, value);
+    case Register::C:
+      return registers.setU8(Reg8::C, value);
+    case Register::D:
+      return registers.setU8(Reg8::D, value);
+    case Register::E:
+      return registers.setU8(Reg8::E, value);
+    case Register::H:
+      return registers.setU8(Reg8::H, value);
+    case Register::L:
+      return registers.setU8(Reg8::L, value);
+    case Register::HL_ptr:
+      return writeU8(registers.getU16(Reg16::HL).decay(), value);
+    case Register::BC_ptr:
+      return writeU8(registers.getU16(Reg16::BC).decay(), value);
+    case Register::DE_ptr:
+      return writeU8(registers.getU16(Reg16::DE).decay(), value);
+    default:
+      throw std::runtime_error("Register cannot be converted to u8");
+  }
+}
+
+template <Register reg>
+auto CPU::getRegU16() -> Word {
+  switch (reg) {
+    case Register::AF:
+      return registers.getU16(Reg16::AF);
+    case Register::HL:
+      return registers.getU16(Reg16::HL);
+    case Register::BC:
+      return registers.getU16(Reg16::BC);
+    case Register::DE:
+      return registers.getU16(Reg16::DE);
+    case Register::SP:
+      return registers.getU16(Reg16::SP);
+    case Register::PC:
+      return registers.getU16(Reg16::PC);
+    default:
+      throw std::runtime_error("Register cannot be converted to u16");
+  }
+}
+
+template <Register reg>
+auto CPU::setRegU16(Word value) -> void {
+  switch (reg) {
+    case Register::AF:
+      return registers.setU16(Reg16::AF, value);
+    case Register::HL:
+      return registers.setU16(Reg16::HL, value);
+    case Register::BC:
+      return registers.setU16(Reg16::BC, value);
+    case Register::DE:
+      return registers.setU16(Reg16::DE, value);
+    case Register::SP:
+      return registers.setU16(Reg16::SP, value);
+    case Register::PC:
+      return setPC(value.decay());
+    default:
+      throw std::runtime_error("Register cannot be converted to u16");
+  }
+}
+
+// One handler per opcode: `opcode` is a template parameter so the switch below
+// (and every operand register) is resolved at compile time.
+const std::array<CPU::OpcodeHandler, 0x100> CPU::opcodeHandlers =
+    []<size_t... opcodes>(std::index_sequence<opcodes...>) {
+      return std::array<OpcodeHandler, 0x100>{
+          &CPU::executeOpcode<opcodes>...};
+    }(std::make_index_sequence<0x100>{});
+
+const std::array<CPU::OpcodeHandler, 0x100> CPU::cbOpcodeHandlers =
+    []<size_t... opcodes>(std::index_sequence<opcodes...>) {
+      return std::array<OpcodeHandler, 0x100>{
+          &CPU::executeCBOpcode<opcodes>...};
+    }(std::make_index_sequence<0x100>{});
+
+// Defined here so they are inlined into the opcode handlers
+inline auto CPU::advancePC1Byte() -> uint8_t {
+  // Returns the 8-Bit value pointed to by the program counter, increments the
+  // counter
+  if (rom_fetch != nullptr) {
+    io->cycle++;
+    registers.pc++;
+    return *rom_fetch++;
+  }
+  return readU8(incrementPC()).decay();
+}
+
+inline auto CPU::advancePC2Bytes() -> uint16_t {
+  // Returns the 16-Bit value pointed to by the program counter, increments the
+  // counter twice
+  if (rom_fetch != nullptr) {
+    io->cycle += 2;
+    registers.pc += 2;
+    const auto result = (uint16_t)(rom_fetch[0] | (rom_fetch[1] << 8U));
+    rom_fetch += 2;
+    return result;
+  }
+  Word result = readU16(registers.pc);
+  setPC(registers.pc + 2);
+  return result.decay();
+}
+
+inline auto CPU::stepInstruction() -> void {
+  /*
+  Instructions in ROM are fetched straight from the host memory the page table
+  points at, so bank switches need no invalidation. None of readU8's checks
+  can fail there: ROM is always defined, the PC stays valid (at most 3 bytes,
+  all on one page) and DMA can't start before the operands are fetched.
+  */
+  const uint16_t pc = registers.pc;
+  if (pc <= 0x7FFC && (pc & 0xFFU) <= 0xFD && not io->isInDMA()) {
+    rom_fetch = memory_map->romData(pc);
+  }
+
   auto const opcode = advancePC1Byte();
+  (this->*opcodeHandlers[opcode])();
+  rom_fetch = nullptr;
+}
+
+inline auto CPU::retireInstruction() -> void {
+  instruction_count++;
+  registers.IME[0] = registers.IME[1];
+  registers.IME[1] = registers.IME[2];
+
+  // Instruction was successful, commit registers for easier debugging. A
+  // faulting instruction still completes, the debugger sees the state before it
+  if (not errors->isStopPending()) {
+    comitted_registers = registers;
+  }
+}
+
+inline auto CPU::findBlock() -> const CachedBlock* {
+  /*
+  Returns the block starting at PC, decoding it on a miss. Only ROM and high
+  RAM are cached, execution anywhere else reports an error on every fetch.
+  */
+  const uint16_t pc = registers.pc;
+  const uint8_t* source = nullptr;
+  size_t slot = 0;
+  if (pc <= 0x7FFF) {
+    source = memory_map->romData(pc);
+    if (source == nullptr) {
+      return nullptr;
+    }
+    slot = pc;
+  } else if (0xFF80 <= pc && pc <= 0xFFFE) {
+    slot = 0x8000 + (pc - 0xFF80);
+  } else {
+    return nullptr;
+  }
+
+  CachedBlock& block = blocks[slot];
+  if (not block.valid || block.source != source) {
+    block = decodeBlock(pc, source);
+  }
+  return block.count == 0 ? nullptr : &block;
+}
+
+inline auto CPU::executeCached(const CachedInstruction& instruction) -> void {
+  // The opcode fetch, operands are fetched by the handler
+  io->cycle++;
+  registers.pc++;
+  rom_fetch = &instruction.bytes[1];
+  (this->*instruction.handler)();
+  rom_fetch = nullptr;
+}
+
+auto CPU::processNextInstruction() -> void {
+  /*
+  Runs the cached block at PC, or a single instruction if there is none.
+  Between two instructions runUntil would update IO once the next event is
+  due, stop on an error and take interrupts. None of that can happen inside a
+  block: interrupts are only raised by IO updates or writes to IF/IE, and IME
+  only changes on the instruction that ends a block. A block that finishes
+  before the next event runs without checking the time, one that doesn't
+  checks it before every instruction. Writes that could change the code or
+  reschedule IO end the block early. Single steps ('idle_until' == 0) only
+  ever run one instruction.
+  */
+  const CachedBlock* block = findBlock();
+  if (block == nullptr || io->isInDMA()) {
+    stepInstruction();
+    retireInstruction();
+    return;
+  }
+
+  const bool is_continuing = idle_until != 0 &&
+                             registers.IME[0] == registers.IME[1] &&
+                             registers.IME[1] == registers.IME[2];
+  const uint64_t deadline = idleTarget();
+  const bool fits = io->cycle + block->cycles < deadline;
+
+  const CachedInstruction* instruction = &cached_instructions[block->first];
+  const CachedInstruction* const end = instruction + block->count;
+  block_break = false;
+  executeCached(*instruction);
+  retireInstruction();
+  while (++instruction != end && is_continuing && not block_break &&
+         not errors->isStopPending() && (fits || io->cycle < deadline)) {
+    executeCached(*instruction);
+    retireInstruction();
+  }
+}
+
+template <uint8_t opcode>
+auto CPU::executeOpcode() -> void {
+  // Operands encoded in the opcode
+  constexpr auto r_src = registerOpcodes[opcode & 0x07U];
+  constexpr auto r_dst = registerOpcodes[(opcode >> 3U) & 0x07U];
+  constexpr auto rr = register16Opcodes[(opcode >> 4U) & 0x03U];
+  constexpr auto rr_stack = register16StackOpcodes[(opcode >> 4U) & 0x03U];
 
   switch (opcode) {
       // 8-Bit loads
@@ -31,61 +284,30 @@ auto CPU::processNextInstruction() -> void {
     case 0x26:
     case 0x2E:
     case 0x36:
-      LD_r_n(registerOpcodes[(opcode - 0x06U) >> 3U], advancePC1Byte());
+    case 0x3E:
+      setRegU8<r_dst>(Byte{advancePC1Byte()});
       break;
     // LD r1,r2
-    case 0x78 ... 0x7F:  // LD a, n
-      LD_r1_r2(Register::A, registerOpcodes[opcode - 0x78U]);
-      break;
-    case 0x40 ... 0x46:  // LD b, n
-      LD_r1_r2(Register::B, registerOpcodes[opcode - 0x40U]);
-      break;
-    case 0x48 ... 0x4E:  // LD c, n
-      LD_r1_r2(Register::C, registerOpcodes[opcode - 0x48U]);
-      break;
-    case 0x50 ... 0x56:  // LD d, n
-      LD_r1_r2(Register::D, registerOpcodes[opcode - 0x50U]);
-      break;
-    case 0x58 ... 0x5E:  // LD e, n
-      LD_r1_r2(Register::E, registerOpcodes[opcode - 0x58U]);
-      break;
-    case 0x60 ... 0x66:  // LD h, n
-      LD_r1_r2(Register::H, registerOpcodes[opcode - 0x60U]);
-      break;
-    case 0x68 ... 0x6E:  // LD l, n
-      LD_r1_r2(Register::L, registerOpcodes[opcode - 0x68U]);
-      break;
-    case 0x70 ... 0x75:  // LD (HL), n
-      LD_r1_r2(Register::HL_ptr, registerOpcodes[opcode - 0x70U]);
+    case 0x40 ... 0x75:
+    case 0x77 ... 0x7F:
+      setRegU8<r_dst>(getRegU8<r_src>());
       break;
     // LD A,n
     case 0x0A:  // LD A, (BC)
-      LD_r1_r2(Register::A, Register::BC_ptr);
+      setRegU8<Register::A>(getRegU8<Register::BC_ptr>());
       break;
     case 0x1A:  // LD A, (DE)
-      LD_r1_r2(Register::A, Register::DE_ptr);
+      setRegU8<Register::A>(getRegU8<Register::DE_ptr>());
       break;
     case 0xFA:  // LD A, (nn)
-      LD_r_nn(Register::A, advancePC2Bytes());
-      break;
-    case 0x3E:  // LD A, #
-      LD_r_n(Register::A, advancePC1Byte());
+      setRegU8<Register::A>(readU8(advancePC2Bytes()));
       break;
     // LD n, A
-    case 0X47:
-    case 0X4F:
-    case 0X57:
-    case 0X5F:
-    case 0X67:
-    case 0X6F:
-    case 0x77:
-      LD_r_A(registerOpcodes[(opcode - 0X47U) >> 3U]);
-      break;
     case 0x02:  // LD (BC),A
-      LD_r_A(Register::BC_ptr);
+      setRegU8<Register::BC_ptr>(registers.a);
       break;
     case 0X12:  // LD (DE),A
-      LD_r_A(Register::DE_ptr);
+      setRegU8<Register::DE_ptr>(registers.a);
       break;
     case 0xEA:  // LD (nn),A
       LD_nn_A(advancePC2Bytes());
@@ -120,7 +342,7 @@ auto CPU::processNextInstruction() -> void {
     case 0x11:
     case 0x21:
     case 0x31:
-      LD16_n_nn(register16Opcodes[opcode >> 4U], advancePC2Bytes());
+      setRegU16<rr>(Word{advancePC2Bytes()});
       break;
     case 0xF9:  // LD SP,HL
       LD16_SP_HL();
@@ -132,139 +354,99 @@ auto CPU::processNextInstruction() -> void {
       LD_nn_SP(advancePC2Bytes());
       break;
     // PUSH
-    case 0xF5:  // PUSH AF
-      PUSH(Register::AF);
-      break;
     case 0xC5:  // PUSH BC
-      PUSH(Register::BC);
-      break;
     case 0xD5:  // PUSH DE
-      PUSH(Register::DE);
-      break;
     case 0xE5:  // PUSH HL
-      PUSH(Register::HL);
+    case 0xF5:  // PUSH AF
+      PUSH(getRegU16<rr_stack>());
       break;
     // POP
-    case 0xF1:  // POP AF
-      POP(Register::AF);
-      break;
     case 0xC1:  // POP BC
-      POP(Register::BC);
-      break;
     case 0xD1:  // POP DE
-      POP(Register::DE);
-      break;
     case 0xE1:  // POP HL
-      POP(Register::HL);
+    case 0xF1:  // POP AF
+      setRegU16<rr_stack>(POP());
       break;
       // 8-Bit ALU
       // ADD
     case 0x80 ... 0x87:  // ADD A, n
-      ADD_n(getRegU8(registerOpcodes[opcode - 0x80U]), false);
+      ADD_n(getRegU8<r_src>(), false);
       break;
     case 0xC6:  // Add A, #
       ADD_n(Byte{advancePC1Byte()}, false);
       break;
     // ADC
     case 0x88 ... 0x8F:  // ADC A, n
-      ADC_n(getRegU8(registerOpcodes[opcode - 0x88U]));
+      ADC_n(getRegU8<r_src>());
       break;
     case 0xCE:  // ADC A, #
       ADC_n(Byte{advancePC1Byte()});
       break;
     // SUB
     case 0x90 ... 0x97:  // SUB n
-      SUB_n(getRegU8(registerOpcodes[opcode - 0x90U]), false);
+      SUB_n(getRegU8<r_src>(), false);
       break;
     case 0xD6:  // SUB #
       SUB_n(Byte{advancePC1Byte()}, false);
       break;
     // SBC
     case 0x98 ... 0x9F:  // SBC A,n
-      SBC_n(getRegU8(registerOpcodes[opcode - 0x98U]));
+      SBC_n(getRegU8<r_src>());
       break;
     case 0xDE:  // SBC A, #
       SBC_n(Byte{advancePC1Byte()});
       break;
     // AND
     case 0xA0 ... 0xA7:  // AND n
-      AND_n(getRegU8(registerOpcodes[opcode - 0xA0U]));
+      AND_n(getRegU8<r_src>());
       break;
     case 0xE6:  // AND #
       AND_n(Byte{advancePC1Byte()});
       break;
     // OR
     case 0xB0 ... 0xB7:  // OR n
-      OR_n(getRegU8(registerOpcodes[opcode - 0xB0]));
+      OR_n(getRegU8<r_src>());
       break;
     case 0xF6:  // OR #
       OR_n(Byte{advancePC1Byte()});
       break;
     // XOR
     case 0xA8 ... 0xAF:  // XOR n
-      XOR_n(getRegU8(registerOpcodes[opcode - 0xA8]));
+      XOR_n(getRegU8<r_src>());
       break;
     case 0xEE:  // XOR #
       XOR_n(Byte{advancePC1Byte()});
       break;
     // CP
     case 0xB8 ... 0xBF:  // CP n
-      CP_n(getRegU8(registerOpcodes[opcode - 0xB8]));
+      CP_n(getRegU8<r_src>());
       break;
     case 0xFE:  // CP #
       CP_n(Byte{advancePC1Byte()});
       break;
 
     // INC
-    case 0x3C:  // INC A
-      INC_r(Register::A);
-      break;
     case 0x04:  // INC B
-      INC_r(Register::B);
-      break;
     case 0x0C:  // INC C
-      INC_r(Register::C);
-      break;
     case 0x14:  // INC D
-      INC_r(Register::D);
-      break;
     case 0x1C:  // INC E
-      INC_r(Register::E);
-      break;
     case 0x24:  // INC H
-      INC_r(Register::H);
-      break;
     case 0x2C:  // INC L
-      INC_r(Register::L);
-      break;
     case 0x34:  // INC (HL)
-      INC_r(Register::HL_ptr);
+    case 0x3C:  // INC A
+      setRegU8<r_dst>(INC_r(getRegU8<r_dst>()));
       break;
 
     // DEC
-    case 0x3D:  // DEC A
-      DEC_r(Register::A);
-      break;
     case 0x05:  // DEC B
-      DEC_r(Register::B);
-      break;
     case 0x0D:  // DEC C
-      DEC_r(Register::C);
-      break;
     case 0x15:  // DEC D
-      DEC_r(Register::D);
-      break;
     case 0x1D:  // DEC E
-      DEC_r(Register::E);
-      break;
     case 0x25:  // DEC H
-      DEC_r(Register::H);
-      break;
     case 0x2D:  // DEC L
-      DEC_r(Register::L);
-      break;
     case 0x35:  // DEC (HL)
-      DEC_r(Register::HL_ptr);
+    case 0x3D:  // DEC A
+      setRegU8<r_dst>(DEC_r(getRegU8<r_dst>()));
       break;
 
       // 16-Bit ALU
@@ -273,7 +455,7 @@ auto CPU::processNextInstruction() -> void {
     case 0x19:
     case 0x29:
     case 0x39:
-      ADD16_HL_n(register16Opcodes[opcode >> 4U]);
+      ADD16_HL_n(getRegU16<rr>());
       break;
     // ADD SP,n
     case 0xE8:
@@ -284,14 +466,14 @@ auto CPU::processNextInstruction() -> void {
     case 0x13:
     case 0x23:
     case 0x33:
-      INC16_nn(register16Opcodes[opcode >> 4U]);
+      setRegU16<rr>(INC16_nn(getRegU16<rr>()));
       break;
     // DEC nn
     case 0x0B:
     case 0x1B:
     case 0x2B:
     case 0x3B:
-      DEC16_nn(register16Opcodes[opcode >> 4U]);
+      setRegU16<rr>(DEC16_nn(getRegU16<rr>()));
       break;
 
       // Miscellaneous
@@ -327,54 +509,9 @@ auto CPU::processNextInstruction() -> void {
       // Rotates and shifts, Bit Operations
       // Many functions: instruction 0xCB changes depending on args
       // Luckily all decode easily
-    case 0xCB: {
-      auto const arg = advancePC1Byte();
-      switch (arg) {
-        // TODO: Possibly need to decrement cycle count here
-        // Rotates and Shifts
-        case 0x00 ... 0x07:  // RLC n
-          RLC_r(registerOpcodes[arg]);
-          break;
-        case 0x08 ... 0x0F:  // RRC n
-          RRC_r(registerOpcodes[arg - 0x08]);
-          break;
-        case 0x10 ... 0x17:  // RL n
-          RL_r(registerOpcodes[arg - 0x10]);
-          break;
-        case 0x18 ... 0x1F:  // RR n
-          RR_r(registerOpcodes[arg - 0x18]);
-          break;
-        case 0x20 ... 0x27:  // SLA n
-          SLA_n(registerOpcodes[arg - 0x20]);
-          break;
-        case 0x28 ... 0x2F:  // SRA n
-          SRA_n(registerOpcodes[arg - 0x28]);
-          break;
-        case 0x30 ... 0x37:  // SWAP
-          SWAP_n(registerOpcodes[arg - 0x30]);
-          break;
-        case 0x38 ... 0x3F:  // SRL n
-          SRL_n(registerOpcodes[arg - 0x38]);
-          break;
-        // Bit Operations
-        case 0x40 ... 0x7F:  // BIT b,r
-          BIT_b_r((arg - 0x40U) >> 3U, registerOpcodes[arg % 0x08]);
-          break;
-        case 0x80 ... 0xBF:  // RES b,r
-          RES_b_r((arg - 0x80U) >> 3U, registerOpcodes[arg % 0x08]);
-          break;
-        case 0xC0 ... 0xFF:  // SET b,r
-          SET_b_r((arg - 0xC0U) >> 3U, registerOpcodes[arg % 0x08]);
-          break;
-        default:
-          throw_error([&] {
-            return BadOpcode(
-                std::format("Bad opcode {:#02x}{:#02x}", opcode, arg));
-          });
-          break;
-      }
+    case 0xCB:
+      (this->*cbOpcodeHandlers[advancePC1Byte()])();
       break;
-    }
 
     case 0x07:  // RLCA
       RLCA();
@@ -455,7 +592,7 @@ auto CPU::processNextInstruction() -> void {
     case 0xEF:
     case 0xF7:
     case 0xFF:
-      RST_n(opcode - 0xC7);
+      RST_n(opcode & 0x38U);
       break;
 
       // Returns
@@ -481,20 +618,66 @@ auto CPU::processNextInstruction() -> void {
       break;
 
     case 0xD3:
-      throw_error([&] {
+      report_error(*errors, [&] {
         return Trap{std::format("Trap executed @ {:#06x}", registers.pc)};
       });
       break;
     case 0xE3:
-      throw_error([&] {
+      report_error(*errors, [&] {
         return DebugTrap{
             std::format("DebugTrap executed @ {:#06x}", registers.pc)};
       });
       break;
     default:
-      throw_error([&] {
+      report_error(*errors, [&] {
         return BadOpcode{
             std::format("Bad opcode {:#04x} @ {:#06x}", opcode, registers.pc)};
       });
   }
 }
+
+template <uint8_t arg>
+auto CPU::executeCBOpcode() -> void {
+  // Operands encoded in the CB argument
+  constexpr auto r = registerOpcodes[arg & 0x07U];
+  constexpr uint8_t bit = (arg >> 3U) & 0x07U;
+
+  switch (arg) {
+    // TODO: Possibly need to decrement cycle count here
+    // Rotates and Shifts
+    case 0x00 ... 0x07:  // RLC n
+      setRegU8<r>(RLC_r(getRegU8<r>()));
+      break;
+    case 0x08 ... 0x0F:  // RRC n
+      setRegU8<r>(RRC_r(getRegU8<r>()));
+      break;
+    case 0x10 ... 0x17:  // RL n
+      setRegU8<r>(RL_r(getRegU8<r>()));
+      break;
+    case 0x18 ... 0x1F:  // RR n
+      setRegU8<r>(RR_r(getRegU8<r>()));
+      break;
+    case 0x20 ... 0x27:  // SLA n
+      setRegU8<r>(SLA_n(getRegU8<r>()));
+      break;
+    case 0x28 ... 0x2F:  // SRA n
+      setRegU8<r>(SRA_n(getRegU8<r>()));
+      break;
+    case 0x30 ... 0x37:  // SWAP
+      setRegU8<r>(SWAP_n(getRegU8<r>()));
+      break;
+    case 0x38 ... 0x3F:  // SRL n
+      setRegU8<r>(SRL_n(getRegU8<r>()));
+      break;
+    // Bit Operations
+    case 0x40 ... 0x7F:  // BIT b,r
+      BIT_b_r(bit, getRegU8<r>());
+      break;
+    case 0x80 ... 0xBF:  // RES b,r
+      setRegU8<r>(RES_b_r(bit, getRegU8<r>()));
+      break;
+    case 0xC0 ... 0xFF:  // SET b,r
+      setRegU8<r>(SET_b_r(bit, getRegU8<r>()));
+      break;
+  }
+}
@@ -4,7 +4,6 @@
 
 #include <array>
 #include <cstdint>
-#include <format>
 #include <utility>
 
 namespace gb {
@@ -181,21 +180,7 @@ struct CPURegisters {
     }
   }
 
-  auto setPC(uint16_t value) -> void {
-    if (not is_valid_pc(value)) {
-      throw_error([&] {
-        return PCOutsideProgramMemory(std::format(
-            "Attempting to assign {:#06x} to PC (currently {:#06x})", value,
-            pc));
-      });
-    }
-    pc = value;
-  }
-
-  auto incrementPC() -> uint16_t {
-    auto old_pc = pc;
-    setPC(pc + 1);
-    return old_pc;
-  }
+  // Not sanitized, the CPU checks jumps against its error policy
+  auto setPC(uint16_t value) -> void { pc = value; }
 };
 }  // namespace gb
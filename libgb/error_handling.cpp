@@ -1,12 +1,51 @@
 #include "error_handling.hpp"
 
 #include <array>
+#include <string_view>
 
 namespace gb {
-std::array<unsigned, error_kind_count> error_count = {};
-std::array<bool, error_kind_count> error_kind_permitted = {};
+thread_local ErrorPolicy* active_error_policy = nullptr;
+
+auto default_error_policy() -> ErrorPolicy& {
+  static ErrorPolicy policy;
+  return policy;
+}
 
 auto permit_error_kind(ErrorKind kind) -> void {
-  error_kind_permitted[static_cast<size_t>(kind)] = true;
+  default_error_policy().permit(kind);
+}
+
+auto error_kind_name(ErrorKind kind) -> std::string_view {
+  switch (kind) {
+    case ErrorKind::bad_opcode:
+      return "bad_opcode";
+    case ErrorKind::trap:
+      return "trap";
+    case ErrorKind::debug_trap:
+      return "debug_trap";
+    case ErrorKind::illegal_memory_address:
+      return "illegal_memory_address";
+    case ErrorKind::illegal_memory_write:
+      return "illegal_memory_write";
+    case ErrorKind::undefined_data:
+      return "undefined_data";
+    case ErrorKind::call_frame_violation:
+      return "call_frame_violation";
+    case ErrorKind::pc_outside_of_program_memory:
+      return "pc_outside_of_program_memory";
+    case ErrorKind::clobbered_return_address:
+      return "clobbered_return_address";
+    case ErrorKind::reading_return_address:
+      return "reading_return_address";
+    case ErrorKind::ppu_access_violation:
+      return "ppu_access_violation";
+    case ErrorKind::lcd_disable_violation:
+      return "lcd_disable_violation";
+    case ErrorKind::dma_bus_conflict:
+      return "dma_bus_conflict";
+    case ErrorKind::_last:
+      break;
+  }
+  return "unknown";
 }
 }  // namespace gb
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <array>
+#include <exception>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace gb {
 
@@ -122,20 +125,122 @@ class DMABusConflict : public CorrectnessError {
   using CorrectnessError::CorrectnessError;
 };
 
-extern std::array<unsigned, error_kind_count> error_count;
-extern std::array<bool, error_kind_count> error_kind_permitted;
+class ErrorPolicy {
+  /*
+  Decides which sanitizer errors stop the emulator and counts every error
+  reported, permitted or not. Each GB owns one and its components keep a
+  pointer to it, so emulators on different threads never share any state.
+
+  Reporting never throws the reported error. The first error that isn't
+  permitted becomes a pending stop, the emulator finishes the current
+  instruction and the GB API rethrows it from there (see throwPending).
+  Everything in between behaves as if the error was permitted. Storing that
+  error allocates (its message and the exception_ptr), so reporting can still
+  throw std::bad_alloc.
+  */
+  std::array<bool, error_kind_count> permitted = {};
+  std::array<unsigned, error_kind_count> counts = {};
+
+  bool stopPending = false;
+  ErrorKind pendingKind = ErrorKind::_last;
+  std::exception_ptr pendingError;
+
+ public:
+  auto permit(ErrorKind kind) -> void {
+    permitted[static_cast<size_t>(kind)] = true;
+  }
+  [[nodiscard]] auto isPermitted(ErrorKind kind) const -> bool {
+    return permitted[static_cast<size_t>(kind)];
+  }
+
+  [[nodiscard]] auto count(ErrorKind kind) const -> unsigned {
+    return counts[static_cast<size_t>(kind)];
+  }
+  [[nodiscard]] auto errorCounts() const
+      -> const std::array<unsigned, error_kind_count>& {
+    return counts;
+  }
+  auto resetCounts() -> void { counts = {}; }
+
+  template <typename Fn>
+  auto report(Fn&& get_error) -> void {
+    using ErrorT = decltype(get_error());
+    constexpr auto kind = static_cast<size_t>(ErrorT::kind);
+
+    counts[kind] += 1;
+    if (not permitted[kind] && not stopPending) {
+      stopPending = true;
+      pendingKind = ErrorT::kind;
+      pendingError = std::make_exception_ptr(get_error());
+    }
+  }
+
+  [[nodiscard]] auto isStopPending() const noexcept -> bool {
+    return stopPending;
+  }
+  // Only meaningful while a stop is pending
+  [[nodiscard]] auto pendingErrorKind() const -> ErrorKind {
+    return pendingKind;
+  }
+
+  auto clearPending() -> void {
+    stopPending = false;
+    pendingKind = ErrorKind::_last;
+    pendingError = nullptr;
+  }
+
+  // Clears the pending stop (if any) and throws the error behind it
+  auto throwPending() -> void {
+    if (stopPending) {
+      auto error = std::exchange(pendingError, nullptr);
+      clearPending();
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+// Policy that new emulators start with, set it up before creating any
+auto default_error_policy() -> ErrorPolicy&;
+auto permit_error_kind(ErrorKind kind) -> void;
+
+template <typename Fn>
+inline auto report_error(ErrorPolicy& policy, Fn&& get_error) -> void {
+  policy.report(std::forward<Fn>(get_error));
+}
+
+// Byte and Word don't know which emulator they belong to. Their errors go to
+// the policy of the GB running on this thread, which only checked builds
+// install (see ActiveErrorPolicy). Without one (eg. a debugger inspecting
+// memory) nothing is counted and the error is thrown straight away.
+extern thread_local ErrorPolicy* active_error_policy;
 
 template <typename Fn>
-static auto throw_error(Fn&& get_error) -> void {
+inline auto report_value_error(Fn&& get_error) -> void {
   using ErrorT = decltype(get_error());
-  constexpr auto kind = static_cast<size_t>(ErrorT::kind);
 
-  error_count[kind] += 1;
-  if (not error_kind_permitted[kind]) {
+  if (active_error_policy != nullptr) {
+    active_error_policy->report(std::forward<Fn>(get_error));
+  } else if (not default_error_policy().isPermitted(ErrorT::kind)) {
     throw get_error();
   }
 }
 
-auto permit_error_kind(ErrorKind kind) -> void;
+class ActiveErrorPolicy {
+#ifndef GB_UNCHECKED_INTS
+  ErrorPolicy* previous;
+
+ public:
+  explicit ActiveErrorPolicy(ErrorPolicy& policy)
+      : previous(std::exchange(active_error_policy, &policy)) {}
+  ~ActiveErrorPolicy() { active_error_policy = previous; }
+#else
+ public:
+  explicit ActiveErrorPolicy(ErrorPolicy&) {}
+#endif
+  ActiveErrorPolicy(const ActiveErrorPolicy&) = delete;
+  auto operator=(const ActiveErrorPolicy&) -> ActiveErrorPolicy& = delete;
+};
+
+[[nodiscard]] auto error_kind_name(ErrorKind kind) -> std::string_view;
 
 }  // namespace gb
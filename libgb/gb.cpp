@@ -1,29 +1,69 @@
 #include "gb.hpp"
 #include "cartridge.hpp"
+#include "constants.hpp"
 #include "error_handling.hpp"
+#include "rewind.hpp"
+#include "utils/save_state.hpp"
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <format>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <span>
+#include <stdexcept>
 #include <string_view>
 #include <type_traits>
 
 using namespace gb;
 
+namespace {
+struct SaveStateHeader {
+  // Bump the version whenever any component changes what it saves
+  static constexpr std::array<char, 4> expected_magic = {'G', 'B', 'S', 'S'};
+  static constexpr uint16_t current_version = 3;
+  static constexpr uint16_t checked_ints_flag = 1U << 0U;
+
+  std::array<char, 4> magic;
+  uint16_t version;
+  uint16_t flags;
+  uint16_t rom_checksum;
+  uint16_t reserved;
+  uint32_t size;
+};
+// Padding would make identical states compare (and delta encode) differently
+static_assert(std::has_unique_object_representations_v<SaveStateHeader>);
+
+auto saveStateFlags() -> uint16_t {
+  return checked_ints_by_default ? SaveStateHeader::checked_ints_flag : 0;
+}
+}  // namespace
+
 GB::GB(std::string_view rom_file, std::unique_ptr<IOFrontend> io_frontend)
-    : cartridge(Cartridge::loadFromRom(rom_file)),
-      io(std::move(io_frontend)),
-      memory_map(cartridge, io),
-      cpu(memory_map, io) {}
+    : GB(Cartridge::loadFromRom(rom_file), std::move(io_frontend)) {}
 
-auto GB::readU8(uint16_t addr) const -> Byte {
-  return memory_map.read(addr);
+GB::GB(std::span<const uint8_t> rom, std::unique_ptr<IOFrontend> io_frontend)
+    : GB(Cartridge::loadFromMemory(rom), std::move(io_frontend)) {}
+
+GB::GB(Cartridge&& loaded_cartridge, std::unique_ptr<IOFrontend> io_frontend)
+    : errors(default_error_policy()),
+      cartridge(std::move(loaded_cartridge)),
+      io(std::move(io_frontend), errors),
+      memory_map(cartridge, io, errors),
+      cpu(memory_map, io, errors) {}
+
+auto GB::readU8(uint16_t addr) -> Byte {
+  const Byte result = memory_map.read(addr);
+  errors.throwPending();
+  return result;
 }
 
-auto GB::readU16(uint16_t addr) const -> Word {
-  return {memory_map.read(addr + 1), memory_map.read(addr)};
+auto GB::readU16(uint16_t addr) -> Word {
+  const Word result = {memory_map.read(addr + 1), memory_map.read(addr)};
+  errors.throwPending();
+  return result;
 }
 
 auto GB::getCurrentRegisters() -> CPURegisters& {
@@ -39,25 +79,186 @@ auto GB::isSimulationFinished() -> bool {
 }
 
 auto GB::reset() -> void {
+  const ActiveErrorPolicy active{errors};
+  errors.clearPending();
   io.reset();
   memory_map.reset();
   cpu.reset();
 }
 
+auto GB::flush() -> void {
+  cartridge.flush();
+}
+
 auto GB::clock() -> void {
+  const ActiveErrorPolicy active{errors};
   // Update timers for accurate delays
   // LCD update for drawing and interrupts
-  io.update();
+  // Nothing observable changes between scheduled events, skip the update
+  if (io.isUpdateDue()) {
+    io.update();
+  }
 
   // Clock CPU to process interrupts etc.
   cpu.clock();
+  errors.throwPending();
+}
+
+template <bool check_breakpoints>
+auto GB::runUntil(uint64_t end_cycle, uint64_t end_frame) -> StopReason {
+  /*
+  Runs instructions until 'end_cycle' is reached or 'end_frame' frames have
+  been drawn. Frames and exit requests only change on an IO update, so they
+  are not checked between scheduled events. Errors only stop execution at an
+  instruction boundary, traps are returned and anything else is thrown.
+  */
+  const ActiveErrorPolicy active{errors};
+  while (io.cycle < end_cycle && not errors.isStopPending()) {
+    if (io.isUpdateDue()) {
+      io.update();
+      if (io.frameCount() >= end_frame) {
+        return StopReason::budget_exhausted;
+      }
+      if (io.isSimulationFinished()) {
+        return StopReason::exit;
+      }
+    }
+    // Skipping idle loops would also skip any breakpoints inside them
+    cpu.clock(check_breakpoints ? 0 : end_cycle);
+
+    if constexpr (check_breakpoints) {
+      const auto& registers = cpu.getCurrentRegisters();
+      if (!registers.halt && breakpoints.test(registers.pc) &&
+          not errors.isStopPending()) {
+        return StopReason::breakpoint;
+      }
+    }
+  }
+
+  if (errors.isStopPending()) {
+    switch (errors.pendingErrorKind()) {
+      case ErrorKind::debug_trap:
+        errors.clearPending();
+        return StopReason::debug_trap;
+      case ErrorKind::trap:
+        errors.clearPending();
+        return StopReason::trap;
+      default:
+        errors.throwPending();
+    }
+  }
+  return StopReason::budget_exhausted;
+}
+
+auto GB::saveStateSize() const -> size_t {
+  return saveState({});
+}
+
+auto GB::saveState(std::span<std::byte> buffer) const -> size_t {
+  /*
+  Writes the header followed by each component in a fixed order. An empty
+  buffer only measures the state, any other buffer must be large enough to
+  hold all of it.
+  */
+  auto write_components = [&](StateWriter& writer) {
+    cartridge.saveState(writer);
+    io.saveState(writer);
+    memory_map.saveState(writer);
+    cpu.saveState(writer);
+  };
+
+  StateWriter measure;
+  measure.write(SaveStateHeader{});
+  write_components(measure);
+  if (buffer.empty()) {
+    return measure.size();
+  }
+
+  StateWriter writer{buffer};
+  writer.write(SaveStateHeader{
+      .magic = SaveStateHeader::expected_magic,
+      .version = SaveStateHeader::current_version,
+      .flags = saveStateFlags(),
+      .rom_checksum = cartridge.checksum(),
+      .reserved = 0,
+      .size = (uint32_t)measure.size(),
+  });
+  write_components(writer);
+  return writer.size();
+}
+
+auto GB::loadState(std::span<const std::byte> buffer) -> void {
+  StateReader reader{buffer};
+  SaveStateHeader header{};
+  reader.read(header);
+  if (header.magic != SaveStateHeader::expected_magic) {
+    throw std::runtime_error("Not a save state");
+  }
+  if (header.version != SaveStateHeader::current_version) {
+    throw std::runtime_error(
+        std::format("Unsupported save state version {}, expected {}",
+                    header.version, SaveStateHeader::current_version));
+  }
+  if (header.flags != saveStateFlags()) {
+    throw std::runtime_error(
+        "Save state was created by an incompatible build configuration");
+  }
+  if (header.rom_checksum != cartridge.checksum()) {
+    throw std::runtime_error("Save state was created for a different ROM");
+  }
+  if (header.size > buffer.size()) {
+    throw std::runtime_error(std::format(
+        "Save state is {} bytes, expected {}", buffer.size(), header.size));
+  }
+
+  cartridge.loadState(reader);
+  io.loadState(reader);
+  memory_map.loadState(reader);
+  cpu.loadState(reader);
+}
+
+auto GB::runFor(uint64_t cycles) -> StopReason {
+  const uint64_t end_cycle =
+      cycles > std::numeric_limits<uint64_t>::max() - io.cycle
+          ? std::numeric_limits<uint64_t>::max()
+          : io.cycle + cycles;
+  const uint64_t end_frame = std::numeric_limits<uint64_t>::max();
+
+  if (breakpoints.none()) {
+    return runUntil<false>(end_cycle, end_frame);
+  }
+  return runUntil<true>(end_cycle, end_frame);
+}
+
+auto GB::runUntilVBlank() -> StopReason {
+  return runFrames(1);
+}
+
+auto GB::runFrames(uint64_t frames) -> StopReason {
+  // No frames are drawn while the LCD is disabled, give up after twice the
+  // expected time.
+  const uint64_t end_cycle = io.cycle + 2 * frames * CYCLES_PER_FRAME;
+  const uint64_t end_frame = io.frameCount() + frames;
+
+  if (breakpoints.none()) {
+    return runUntil<false>(end_cycle, end_frame);
+  }
+  return runUntil<true>(end_cycle, end_frame);
+}
+
+auto GB::addBreakpoint(uint16_t addr) -> void {
+  breakpoints.set(addr);
+}
+
+auto GB::removeBreakpoint(uint16_t addr) -> void {
+  breakpoints.reset(addr);
 }
 
 auto GB::insertInterruptOnNextCycle(uint8_t) -> void {
   // TODO
 }
 
-auto gb::run_standalone(gb::GB& gameboy) -> void {
+auto gb::run_standalone(gb::GB& gameboy, RewindBuffer* rewind) -> StopReason {
   auto print_reg = []<typename T>(std::string_view reg, T value) {
     if (value.flags.undefined) {
       std::cout << std::format("{}=XX\n", reg);
@@ -68,11 +269,26 @@ auto gb::run_standalone(gb::GB& gameboy) -> void {
     }
   };
 
+  auto run = [&] {
+    if (rewind == nullptr) {
+      return gameboy.runFor(std::numeric_limits<uint64_t>::max());
+    }
+    if (gameboy.io.isRewindRequested() && rewind->rewind(gameboy)) {
+      // Run the restored frame again to display it, it is not recaptured
+      return gameboy.runFrames(1);
+    }
+    const auto reason = gameboy.runFrames(1);
+    rewind->capture(gameboy);
+    return reason;
+  };
+
   size_t last_debug_trap = 0;
-  while (not gameboy.isSimulationFinished()) {
-    try {
-      gameboy.clock();
-    } catch (const DebugTrap&) {
+  while (true) {
+    const auto reason = run();
+    if (reason == StopReason::budget_exhausted) {
+      continue;
+    }
+    if (reason == StopReason::debug_trap) {
       size_t cycles_since_last = gameboy.io.cycle - last_debug_trap;
 
       std::cout << "Debug trap!" << std::endl;
@@ -86,6 +302,8 @@ auto gb::run_standalone(gb::GB& gameboy) -> void {
       print_reg("e", gameboy.getCurrentRegisters().e);
 
       last_debug_trap = gameboy.io.cycle;
+    } else {
+      return reason;
     }
   }
 }
@@ -2,12 +2,16 @@
 
 #include "cartridge.hpp"
 #include "cpu/cpu.hpp"
+#include "error_handling.hpp"
 #include "io/io.hpp"
 #include "memory_map.hpp"
 
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 
 // http://bgb.bircd.org/pandocs.htm
@@ -20,18 +24,43 @@
 
 namespace gb {
 
+enum class StopReason : uint8_t {
+  budget_exhausted,  // Requested number of cycles/ frames have been run
+  breakpoint,        // PC reached an address passed to addBreakpoint
+  trap,              // Trap instruction (0xD3) executed
+  debug_trap,        // DebugTrap instruction (0xE3) executed
+  exit,              // Frontend requested exit
+};
+
+class RewindBuffer;
+
 class GB {
+  std::bitset<0x10000> breakpoints;
+
+  template <bool check_breakpoints>
+  auto runUntil(uint64_t end_cycle, uint64_t end_frame) -> StopReason;
+
  public:
+  // Starts as a copy of default_error_policy(), it also counts every sanitizer
+  // error this emulator has reported
+  ErrorPolicy errors;
+
   Cartridge cartridge;
   IO io;
   MemoryMap memory_map;
   CPU cpu;
 
+  // Battery backed RAM is not saved, load the Cartridge with a save path to
+  // keep it (see Cartridge::savePathFor)
   GB(std::string_view rom_file, std::unique_ptr<IOFrontend> io_frontend);
+  // 'rom' is owned by the caller and must outlive the emulator
+  GB(std::span<const uint8_t> rom, std::unique_ptr<IOFrontend> io_frontend);
+  GB(Cartridge&& cartridge, std::unique_ptr<IOFrontend> io_frontend);
 
   // Consume 0 CPU cycles
-  [[nodiscard]] auto readU8(uint16_t addr) const -> Byte;
-  [[nodiscard]] auto readU16(uint16_t addr) const -> Word;
+  // Throws if the address cannot be read
+  [[nodiscard]] auto readU8(uint16_t addr) -> Byte;
+  [[nodiscard]] auto readU16(uint16_t addr) -> Word;
 
   [[nodiscard]] auto getCurrentRegisters() -> CPURegisters&;
   [[nodiscard]] auto getDebugRegisters() -> CPURegisters&;
@@ -40,6 +69,24 @@ class GB {
   auto reset() -> void;
   auto clock() -> void;
 
+  // Make sure battery backed RAM has reached the save file
+  auto flush() -> void;
+
+  // Keep running instructions until the budget is exhausted or execution
+  // has to stop. Breakpoints are only checked after the first instruction.
+  auto runFor(uint64_t cycles) -> StopReason;
+  auto runUntilVBlank() -> StopReason;
+  auto runFrames(uint64_t frames) -> StopReason;
+
+  auto addBreakpoint(uint16_t addr) -> void;
+  auto removeBreakpoint(uint16_t addr) -> void;
+
+  // Snapshot of the entire emulated machine, only valid for the same ROM and
+  // build configuration. The frontend and breakpoints are not included.
+  [[nodiscard]] auto saveStateSize() const -> size_t;
+  auto saveState(std::span<std::byte> buffer) const -> size_t;
+  auto loadState(std::span<const std::byte> buffer) -> void;
+
   // Debug
   auto insertInterruptOnNextCycle(uint8_t id) -> void;
 };
@@ -47,7 +94,8 @@ class GB {
 auto load_from_elf(std::unique_ptr<gb::IOFrontend>, std::string_view elf_path)
     -> std::unique_ptr<gb::GB>;
 
-auto run_standalone(gb::GB&) -> void;
+// Captures every frame into 'rewind' and steps back while the frontend asks
+auto run_standalone(gb::GB&, RewindBuffer* rewind = nullptr) -> StopReason;
 
 auto run_gdb_server(uint16_t port,
                     std::unique_ptr<gb::IOFrontend>,
@@ -28,6 +28,7 @@ auto gb::load_from_elf(std::unique_ptr<gb::IOFrontend> frontend,
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -43,15 +44,6 @@ auto gb::load_from_elf(std::unique_ptr<gb::IOFrontend> frontend,
 
 using namespace gb;
 
-namespace {
-auto run_command(std::string cmd) -> void {
-  if (std::system(cmd.c_str()) != 0) {
-    throw std::runtime_error(
-        std::format("Command \"{}\" returned non-zero opcode", cmd));
-  }
-}
-}  // namespace
-
 auto gb::load_from_elf(std::unique_ptr<gb::IOFrontend> frontend,
                        std::string_view elf_path) -> std::unique_ptr<gb::GB> {
   // Use the toolchain to convert the ELF into a cartridge ROM
@@ -61,12 +53,27 @@ auto gb::load_from_elf(std::unique_ptr<gb::IOFrontend> frontend,
     toolchain_prefix = std::string(toolchain_env) + "/";
   }
 
-  auto* tmp_name = std::tmpnam(nullptr);
-  run_command(std::format("{}llvm-objcopy -O binary {} {} --gap-fill 0",
-                          toolchain_prefix, elf_path, tmp_name));
+  // Stream the ROM straight from objcopy, no temporary file is needed
+  const auto cmd = std::format("{}llvm-objcopy -O binary {} - --gap-fill 0",
+                               toolchain_prefix, elf_path);
+  auto* pipe = popen(cmd.c_str(), "r");
+  if (pipe == nullptr) {
+    throw std::runtime_error(std::format("Could not run \"{}\"", cmd));
+  }
+
+  std::vector<uint8_t> rom;
+  std::array<uint8_t, 0x4000> chunk;
+  while (size_t count = std::fread(chunk.data(), 1, chunk.size(), pipe)) {
+    rom.insert(rom.end(), chunk.begin(), chunk.begin() + count);
+  }
+  if (pclose(pipe) != 0) {
+    throw std::runtime_error(
+        std::format("Command \"{}\" returned non-zero opcode", cmd));
+  }
 
-  // Load the emulator with the new rom file
-  return std::make_unique<GB>(tmp_name, std::move(frontend));
+  // Load the emulator with the new rom
+  return std::make_unique<GB>(Cartridge::loadFromBytes(std::move(rom)),
+                              std::move(frontend));
 }
 
 void gb::run_gdb_server(uint16_t port,
@@ -595,6 +595,49 @@ auto APU::rearm_channel3_volume() -> void {
   m_channel3.peek_level = (uint8_t)(io_memory[CHANNEL3_VOLUME] >> 5U) & 0b11U;
 }
 
+auto APU::save_state(StateWriter& writer) const -> void {
+  /*
+  Saves the channel state. Samples waiting for the frontend belong to the host
+  and are not saved.
+  */
+  writer.write(m_clocks_till_sample);
+  writer.write(m_last_clock);
+  writer.write(m_div_apu_counter);
+  writer.write(m_last_div_value);
+  writer.write(m_apu_has_power);
+  writer.write(m_channel1);
+  writer.write(m_channel2);
+  writer.write(m_channel3);
+  writer.write(m_channel4);
+  writer.write(m_channel1_sweep_countdown);
+  writer.write(m_channel1_sweep_active);
+  writer.write(m_channel1_sweep_locked_until_trigger);
+  writer.write(m_channel4_lsr);
+  writer.write(m_number_of_samples);
+  writer.write(m_sum_of_samples_l);
+  writer.write(m_sum_of_samples_r);
+}
+
+auto APU::load_state(StateReader& reader) -> void {
+  reader.read(m_clocks_till_sample);
+  reader.read(m_last_clock);
+  reader.read(m_div_apu_counter);
+  reader.read(m_last_div_value);
+  reader.read(m_apu_has_power);
+  reader.read(m_channel1);
+  reader.read(m_channel2);
+  reader.read(m_channel3);
+  reader.read(m_channel4);
+  reader.read(m_channel1_sweep_countdown);
+  reader.read(m_channel1_sweep_active);
+  reader.read(m_channel1_sweep_locked_until_trigger);
+  reader.read(m_channel4_lsr);
+  reader.read(m_number_of_samples);
+  reader.read(m_sum_of_samples_l);
+  reader.read(m_sum_of_samples_r);
+  m_samples_since_last_flush.clear();
+}
+
 auto APU::power_up() -> void {
   /*
   Powers up the APU while maintaining register values.
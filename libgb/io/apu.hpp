@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../utils/save_state.hpp"
 #include "io_registers.hpp"
 
 #include <cstddef>
@@ -67,6 +68,9 @@ class APU {
   auto write(uint16_t addr, uint8_t value) -> void;
   auto read(uint16_t addr) -> uint8_t;
 
+  auto save_state(StateWriter&) const -> void;
+  auto load_state(StateReader&) -> void;
+
   auto get_samples() -> std::span<std::pair<float, float>>;
   auto flush_samples(size_t count) -> void;
 
@@ -0,0 +1,283 @@
+#include "capture.hpp"
+
+#include "../constants.hpp"
+#include "frontend.hpp"
+#include "io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace gb;
+
+namespace {
+// Raw frames are buffered into large writes, a pipe reader sees whole frames
+constexpr size_t RAW_BUFFER_SIZE = 1 << 20;
+
+constexpr auto CRC_TABLE = [] {
+  std::array<uint32_t, 0x100> table = {};
+  for (uint32_t n = 0; n < table.size(); n++) {
+    uint32_t crc = n;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1U) != 0 ? 0xEDB88320U ^ (crc >> 1U) : crc >> 1U;
+    }
+    table[n] = crc;
+  }
+  return table;
+}();
+
+auto crc32(std::span<const uint8_t> bytes) -> uint32_t {
+  uint32_t crc = 0xFFFFFFFFU;
+  for (const uint8_t byte : bytes) {
+    crc = CRC_TABLE[(crc ^ byte) & 0xFFU] ^ (crc >> 8U);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+auto adler32(std::span<const uint8_t> bytes) -> uint32_t {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (const uint8_t byte : bytes) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16U) | a;
+}
+
+auto append_u32(std::vector<uint8_t>& out, uint32_t value) -> void {
+  // PNG and zlib integers are big endian
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back((uint8_t)(value >> shift));
+  }
+}
+
+auto append_chunk(std::vector<uint8_t>& out,
+                  std::string_view type,
+                  std::span<const uint8_t> data) -> void {
+  append_u32(out, (uint32_t)data.size());
+  const size_t typeStart = out.size();
+  out.insert(out.end(), type.begin(), type.end());
+  out.insert(out.end(), data.begin(), data.end());
+  append_u32(out, crc32(std::span{out}.subspan(typeStart)));
+}
+}  // namespace
+
+auto gb::encode_png(Frame frame) -> std::vector<uint8_t> {
+  /*
+  Writes a 2-bit grayscale PNG. Four pixels fit in a byte, so the whole image
+  is under 6KiB and is stored uncompressed: a single stored deflate block
+  needs no compressor.
+  */
+  constexpr size_t rowBytes = 1 + (SCREEN_WIDTH / 4);  // Filter type + pixels
+  std::vector<uint8_t> scanlines;
+  scanlines.reserve(rowBytes * SCREEN_HEIGHT);
+  for (size_t y = 0; y < SCREEN_HEIGHT; y++) {
+    scanlines.push_back(0);  // No filter
+    for (size_t x = 0; x < SCREEN_WIDTH; x += 4) {
+      uint8_t packed = 0;
+      for (size_t i = 0; i < 4; i++) {
+        // Color index 0 is the lightest shade, gray level 3 is white
+        const uint8_t gray = 3 - (frame[y * SCREEN_WIDTH + x + i] & 0x03U);
+        packed |= gray << (6 - 2 * i);
+      }
+      scanlines.push_back(packed);
+    }
+  }
+  static_assert(rowBytes * SCREEN_HEIGHT <= 0xFFFF);
+
+  std::vector<uint8_t> header;
+  append_u32(header, SCREEN_WIDTH);
+  append_u32(header, SCREEN_HEIGHT);
+  header.insert(header.end(), {
+                                  2,  // Bit depth
+                                  0,  // Grayscale
+                                  0,  // Deflate
+                                  0,  // Adaptive filtering
+                                  0,  // Not interlaced
+                              });
+
+  const auto length = (uint16_t)scanlines.size();
+  std::vector<uint8_t> zlib = {
+      0x78, 0x01,  // Deflate, 32KiB window
+      0x01,        // Final stored block
+      (uint8_t)(length & 0xFFU),
+      (uint8_t)(length >> 8U),
+      (uint8_t)(~length & 0xFFU),
+      (uint8_t)((uint16_t)~length >> 8U),
+  };
+  zlib.insert(zlib.end(), scanlines.begin(), scanlines.end());
+  append_u32(zlib, adler32(scanlines));
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  append_chunk(png, "IHDR", header);
+  append_chunk(png, "IDAT", zlib);
+  append_chunk(png, "IEND", {});
+  return png;
+}
+
+CaptureFrontend::CaptureFrontend(std::unique_ptr<IOFrontend> inner,
+                                 CaptureOptions options)
+    : inner(std::move(inner)), options(std::move(options)) {
+  if (this->options.max_pending_frames == 0) {
+    this->options.max_pending_frames = 1;
+  }
+
+  switch (this->options.format) {
+    case CaptureFormat::png:
+      std::filesystem::create_directories(this->options.path);
+      break;
+    case CaptureFormat::raw:
+      // The buffer must be installed before the file is opened
+      rawBuffer.resize(RAW_BUFFER_SIZE);
+      rawOutput.rdbuf()->pubsetbuf(rawBuffer.data(),
+                                   (std::streamsize)rawBuffer.size());
+      rawOutput.open(this->options.path, std::ios::binary | std::ios::trunc);
+      if (!rawOutput) {
+        throw std::runtime_error(std::format(
+            "Couldn't open capture output '{}'", this->options.path));
+      }
+      break;
+  }
+
+  writer = std::jthread([this] { runWriter(); });
+}
+
+CaptureFrontend::~CaptureFrontend() {
+  // The writer drains the queue before it exits
+  {
+    const std::scoped_lock lock(mutex);
+    isStopping = true;
+  }
+  pendingChanged.notify_all();
+}
+
+auto CaptureFrontend::flush() -> void {
+  std::unique_lock lock(mutex);
+  pendingChanged.wait(lock, [&] { return pending.empty() && writing == 0; });
+
+  // The writer is idle until the next frame is queued
+  if (options.format == CaptureFormat::raw) {
+    rawOutput.flush();
+    if (!rawOutput && !writeError.has_value()) {
+      writeError = std::format("Couldn't write to '{}'", options.path);
+    }
+  }
+  if (writeError.has_value()) {
+    throw std::runtime_error(*writeError);
+  }
+}
+
+auto CaptureFrontend::runWriter() -> void {
+  std::unique_lock lock(mutex);
+  while (true) {
+    pendingChanged.wait(lock, [&] { return isStopping || !pending.empty(); });
+    if (pending.empty()) {
+      return;  // Stopping and every frame is written
+    }
+
+    const PendingFrame frame = std::move(pending.front());
+    pending.pop_front();
+    writing++;
+    lock.unlock();
+    pendingChanged.notify_all();  // There is room for another frame
+
+    std::optional<std::string> error;
+    try {
+      writeFrame(frame);
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+
+    lock.lock();
+    writing--;
+    if (error.has_value() && !writeError.has_value()) {
+      writeError = std::move(error);
+    }
+    pendingChanged.notify_all();
+  }
+}
+
+auto CaptureFrontend::writeFrame(const PendingFrame& frame) -> void {
+  switch (options.format) {
+    case CaptureFormat::png: {
+      const auto path =
+          std::format("{}/frame_{:06}.png", options.path, frame.index);
+      const auto png = encode_png(frame.pixels);
+      std::ofstream output(path, std::ios::binary | std::ios::trunc);
+      output.write((const char*)png.data(), (std::streamsize)png.size());
+      if (!output) {
+        throw std::runtime_error(std::format("Couldn't write '{}'", path));
+      }
+      break;
+    }
+    case CaptureFormat::raw:
+      rawOutput.write((const char*)frame.pixels.data(),
+                      (std::streamsize)frame.pixels.size());
+      if (!rawOutput) {
+        throw std::runtime_error(
+            std::format("Couldn't write to '{}'", options.path));
+      }
+      break;
+  }
+}
+
+auto CaptureFrontend::commitRender(Frame frame) -> void {
+  PendingFrame copy{.index = frameIndex++, .pixels = {}};
+  std::ranges::copy(frame, copy.pixels.begin());
+  inner->commitRender(frame);
+
+  std::unique_lock lock(mutex);
+  if (writeError.has_value()) {
+    return;  // Reported by flush(), don't queue frames that can't be written
+  }
+  pendingChanged.wait(
+      lock, [&] { return pending.size() < options.max_pending_frames; });
+  pending.push_back(std::move(copy));
+  lock.unlock();
+  pendingChanged.notify_all();
+}
+
+auto CaptureFrontend::commitSkippedFrame(Frame last) -> void {
+  frameIndex++;
+  inner->commitSkippedFrame(last);
+}
+
+auto CaptureFrontend::getKeyPressState() -> Key {
+  return inner->getKeyPressState();
+}
+
+auto CaptureFrontend::sendSerial(uint8_t value) -> void {
+  inner->sendSerial(value);
+}
+
+auto CaptureFrontend::isExitRequested() -> bool {
+  return inner->isExitRequested();
+}
+
+auto CaptureFrontend::isRewindRequested() -> bool {
+  return inner->isRewindRequested();
+}
+
+auto CaptureFrontend::get_approx_audio_sample_freq() -> size_t {
+  return inner->get_approx_audio_sample_freq();
+}
+
+auto CaptureFrontend::try_flush_audio(
+    std::span<std::pair<float, float>> samples) -> std::optional<size_t> {
+  return inner->try_flush_audio(samples);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../constants.hpp"
+#include "frontend.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gb {
+
+enum class Key : uint8_t;
+
+enum class CaptureFormat : uint8_t {
+  png,  // One 2-bit grayscale PNG per frame, named frame_<index>.png
+  raw,  // 160x144 color indices per frame, 1 byte per pixel, back to back
+};
+
+struct CaptureOptions {
+  CaptureFormat format = CaptureFormat::raw;
+  std::string path;  // Directory for png, file or named pipe for raw
+
+  // Emulation only waits for the writer once this many frames are queued
+  size_t max_pending_frames = 256;
+};
+
+// Encodes a frame as a PNG, the colors are shades of gray (index 0 is white)
+auto encode_png(Frame frame) -> std::vector<uint8_t>;
+
+class CaptureFrontend : public IOFrontend {
+  /*
+  Forwards everything to 'inner' and writes each drawn frame to disk. Frames
+  are copied into a queue and written by a background thread, so a slow disk
+  or pipe doesn't hold back the emulator. Which frames are drawn is chosen by
+  the GB's RenderPolicy.
+  */
+  using FrameBuffer = std::array<uint8_t, SCREEN_WIDTH * SCREEN_HEIGHT>;
+  struct PendingFrame {
+    uint64_t index;
+    FrameBuffer pixels;
+  };
+
+  std::unique_ptr<IOFrontend> inner;
+  CaptureOptions options;
+  std::ofstream rawOutput;
+  std::vector<char> rawBuffer;
+
+  uint64_t frameIndex = 0;  // Counts skipped frames too
+
+  std::mutex mutex;
+  std::condition_variable pendingChanged;
+  std::deque<PendingFrame> pending;
+  size_t writing = 0;  // Frames taken from 'pending' but not yet written
+  bool isStopping = false;
+  std::optional<std::string> writeError;
+
+  // Declared last, it must be joined before anything it uses is destroyed
+  std::jthread writer;
+
+ public:
+  CaptureFrontend(std::unique_ptr<IOFrontend> inner, CaptureOptions options);
+  CaptureFrontend(const CaptureFrontend&) = delete;
+  auto operator=(const CaptureFrontend&) -> CaptureFrontend& = delete;
+  ~CaptureFrontend() override;
+
+  // Waits until every queued frame is written, throws if any write failed
+  auto flush() -> void;
+
+  auto getKeyPressState() -> Key override;
+  auto sendSerial(uint8_t value) -> void override;
+  auto commitRender(Frame frame) -> void override;
+  auto commitSkippedFrame(Frame last) -> void override;
+  auto isFrameScheduled() -> bool override { return true; };
+  auto isExitRequested() -> bool override;
+  auto isRewindRequested() -> bool override;
+
+  auto get_approx_audio_sample_freq() -> size_t override;
+  auto try_flush_audio(std::span<std::pair<float, float>> samples)
+      -> std::optional<size_t> override;
+
+ private:
+  auto runWriter() -> void;
+  auto writeFrame(const PendingFrame& frame) -> void;
+};
+
+}  // namespace gb
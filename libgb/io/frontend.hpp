@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../constants.hpp"
+
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -9,16 +11,23 @@ namespace gb {
 
 enum class Key : uint8_t;
 
+// Row-major 160x144 screen of color indices (0-3), owned by the GPU.
+// Remains valid and unchanged until the next call to commitRender.
+using Frame = std::span<const uint8_t, SCREEN_WIDTH * SCREEN_HEIGHT>;
+
 class IOFrontend {
  public:
   virtual ~IOFrontend() = default;
 
   virtual auto getKeyPressState() -> Key = 0;
   virtual auto sendSerial(uint8_t value) -> void = 0;
-  virtual auto addPixel(int color, int screenX, int screenY) -> void = 0;
-  virtual auto commitRender() -> void = 0;
+  virtual auto commitRender(Frame frame) -> void = 0;
+  // Called instead of commitRender for frames that weren't drawn, with the
+  // last frame that was
+  virtual auto commitSkippedFrame(Frame last) -> void { commitRender(last); };
   virtual auto isFrameScheduled() -> bool = 0;
   virtual auto isExitRequested() -> bool = 0;
+  virtual auto isRewindRequested() -> bool { return false; };
 
   virtual auto get_approx_audio_sample_freq() -> size_t { return 1028; };
   virtual auto try_flush_audio(std::span<std::pair<float, float>> samples)
@@ -3,7 +3,9 @@
 #include "../constants.hpp"
 #include "../error_handling.hpp"
 #include "frontend.hpp"
+#include "tile_row.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <stdexcept>
@@ -36,16 +38,52 @@ constexpr uint16_t INTERRUPTS = 0xFF0F - IO_OFFSET;
 constexpr uint8_t VSYNC_INTERRUPT = 0x01;
 constexpr uint8_t STAT_INTERRUPT = 0x02;
 
-GPU::GPU(std::span<uint8_t, 0x80> io_memory) : io_memory(io_memory) {
+GPU::GPU(std::span<uint8_t, 0x80> io_memory, ErrorPolicy& errors)
+    : io_memory(io_memory), errors(&errors) {
   reset();
 }
 
 auto GPU::reset() -> void {
   sprites = {};
   patternTables = {};
+  staleTiles.set();
   backgroundMaps = {};
+  frameBuffers = {};
+  backBuffer = 0;
+  frameInputs = {};
   vCycleCount = 0;
   windowOffsetY = 0;
+  isRenderingFrame = false;
+  isDisplayChanged = true;
+}
+
+auto GPU::saveState(StateWriter& writer) const -> void {
+  // A skipped frame hands the front buffer to the frontend again, and whether
+  // the frame in progress is drawn was decided when it started
+  writer.write(sprites);
+  writer.write(patternTables);
+  writer.write(backgroundMaps);
+  writer.write(frameBuffers[backBuffer]);
+  writer.write(frameBuffers[backBuffer ^ 1U]);
+  writer.write(isRenderingFrame);
+  writer.write(vCycleCount);
+  writer.write(vblankCount);
+  writer.write(windowOffsetY);
+}
+
+auto GPU::loadState(StateReader& reader) -> void {
+  reader.read(sprites);
+  reader.read(patternTables);
+  staleTiles.set();
+  reader.read(backgroundMaps);
+  reader.read(frameBuffers[backBuffer]);
+  reader.read(frameBuffers[backBuffer ^ 1U]);
+  reader.read(isRenderingFrame);
+  frameInputs = {};
+  reader.read(vCycleCount);
+  reader.read(vblankCount);
+  reader.read(windowOffsetY);
+  isDisplayChanged = true;
 }
 
 [[nodiscard]] auto GPU::readU8(uint16_t addr, bool is_dma) const -> uint8_t {
@@ -54,7 +92,7 @@ auto GPU::reset() -> void {
     case 0x8000 ... 0x97FF:
       // Tile data 1
       if (!is_dma && mode == 3U) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation("Reading from tile data during pixel blitz");
         });
       }
@@ -62,7 +100,7 @@ auto GPU::reset() -> void {
     case 0x9800 ... 0x9FFF:
       // Background maps
       if (!is_dma && mode == 3U) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation(
               "Reading from background maps during pixel blitz");
         });
@@ -71,7 +109,7 @@ auto GPU::reset() -> void {
     case 0xFE00 ... 0xFE9F:
       // Sprite attributes
       if (!is_dma && (mode == 2U || mode == 3U)) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation(
               "Reading from sprit attribute data during pixel blitz/ OAM scan");
         });
@@ -90,30 +128,43 @@ auto GPU::writeU8(uint16_t addr, uint8_t value, bool is_dma) -> void {
     case 0x8000 ... 0x97FF:
       // Tile data 1
       if (!is_dma && mode == 3U) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation("Writing to tile data during pixel blitz");
         });
       }
+      if (byteFromPatternTable(addr) != value) {
+        tileWrittenAt[(addr - 0x8000U) / 0x10U] = ++displayWrites;
+      }
       const_cast<uint8_t&>(byteFromPatternTable(addr)) = value;
+      staleTiles.set((addr - 0x8000U) / 0x10U);
+      isDisplayChanged = true;
       break;
     case 0x9800 ... 0x9FFF:
       // Background maps
       if (!is_dma && mode == 3U) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation("Writing to background maps during pixel blitz");
         });
       }
+      if (byteFromBackgroundMaps(addr) != value) {
+        mapRowWrittenAt[(addr - 0x9800U) / 0x20U] = ++displayWrites;
+      }
       const_cast<uint8_t&>(byteFromBackgroundMaps(addr)) = value;
+      isDisplayChanged = true;
       break;
     case 0xFE00 ... 0xFE9F:
       // Sprite attributes
       if (!is_dma && (mode == 2U || mode == 3U)) {
-        throw_error([] {
+        report_error(*errors, [] {
           return PPUViolation(
               "Writing to sprit attribute data during pixel blitz/ OAM scan");
         });
       }
+      if (byteFromSpriteAttributes(addr) != value) {
+        spritesWrittenAt = ++displayWrites;
+      }
       const_cast<uint8_t&>(byteFromSpriteAttributes(addr)) = value;
+      isDisplayChanged = true;
       break;
     default:
       throw std::range_error("Bad vram address write");
@@ -156,32 +207,218 @@ auto GPU::byteFromPatternTable(uint16_t addr) const -> uint8_t const& {
       .at(map_offset % 0x20U);
 }
 
-auto GPU::renderLine(IOFrontend& frontend) -> void {
+auto GPU::isFrameRendered(IOFrontend& frontend) -> bool {
   /*
-  Draws the current line (index 0xFF44) onto the display
-  This draws: background, window, sprites
+  Decides whether the frame that is starting is drawn. Writes made while a
+  frame is drawn can change lines that were already drawn, so on_change only
+  skips a frame if nothing was written since the last drawn frame started.
+  Writes made during a frame the frontend didn't schedule are kept for the
+  next one that is drawn.
+  */
+  if (!frontend.isFrameScheduled()) {
+    return false;
+  }
+
+  bool rendered = true;
+  switch (renderPolicy.mode) {
+    case RenderMode::every_frame:
+      rendered = true;
+      break;
+    case RenderMode::every_nth_frame:
+      rendered = renderPolicy.interval != 0 &&
+                 vblankCount % renderPolicy.interval == 0;
+      break;
+    case RenderMode::on_change:
+      rendered = isDisplayChanged;
+      break;
+    case RenderMode::never:
+      rendered = false;
+      break;
+  }
+  if (rendered) {
+    isDisplayChanged = false;
+  }
+  return rendered;
+}
+
+auto GPU::renderLine() -> void {
+  /*
+  Draws the current line (index 0xFF44) into the back frame buffer, or copies
+  it from the front buffer if nothing it is drawn from changed since.
   */
+  decodeStaleTiles();
+
   int screenY = io_memory[LCD_LY];
   if (io_memory[WINDOW_X] <= 166 || (io_memory[LCDC] & 0x20U) != 0) {
     windowOffsetY++;
   }
-  for (int screenX = 0; screenX < SCREEN_WIDTH; screenX++) {
-    uint8_t pixelColor = 0;
-    if ((io_memory[LCDC] & 0x02U) != 0 &&
-        spriteOverridesPixel(screenX, screenY, pixelColor)) {
-      frontend.addPixel(pixelColor, screenX, screenY);
-      continue;
+
+  const LineInputs inputs = currentLineInputs();
+  Line line{&frameBuffers[backBuffer][screenY * SCREEN_WIDTH], SCREEN_WIDTH};
+  if (isLineUnchanged(screenY, inputs)) {
+    const FrameBuffer& front = frameBuffers[backBuffer ^ 1U];
+    std::ranges::copy_n(&front[screenY * SCREEN_WIDTH], SCREEN_WIDTH,
+                        line.begin());
+  } else {
+    drawLine(line, screenY);
+  }
+  frameInputs[backBuffer][screenY] = inputs;
+}
+
+auto GPU::drawLine(Line line, int screenY) const -> void {
+  /*
+  Draws the line 'screenY' into 'line'
+  This draws: background, window, sprites
+  Each layer is drawn a whole tile row at a time.
+  */
+  std::ranges::fill(line, 0);
+  if ((io_memory[LCDC] & 0x01U) != 0) {
+    renderMapLine(line, 0, SCREEN_WIDTH, io_memory[BG_SCX],
+                  screenY + io_memory[BG_SCY], io_memory[LCDC] & 0x08U);
+  }
+
+  // The window always covers the background, even with color 0
+  int windowFromX = 0;
+  int windowToX = 0;
+  int windowY = windowOffsetY - io_memory[WINDOW_Y];
+  if ((io_memory[LCDC] & 0x20U) != 0 && io_memory[WINDOW_X] <= 166 &&
+      windowY >= 0 && windowY < SCREEN_HEIGHT) {
+    int windowStart = io_memory[WINDOW_X] - 7;
+    windowFromX = std::max(0, windowStart);
+    windowToX = std::min<int>(SCREEN_WIDTH, windowStart + SCREEN_WIDTH);
+    renderMapLine(line, windowFromX, windowToX, windowFromX - windowStart,
+                  windowY, io_memory[LCDC] & 0x40U);
+  }
+
+  if ((io_memory[LCDC] & 0x02U) != 0) {
+    std::array<uint8_t, SCREEN_WIDTH> spriteColors = {};
+    std::array<bool, SCREEN_WIDTH> isVisible = {};
+    std::array<bool, SCREEN_WIDTH> isBehindBackground = {};
+    renderSpriteLine(screenY, spriteColors, isVisible, isBehindBackground);
+
+    for (int screenX = 0; screenX < SCREEN_WIDTH; screenX++) {
+      if (!isVisible[screenX]) {
+        continue;
+      }
+      // Background priority sprites only show through background color 0
+      bool isCovered = isBehindBackground[screenX] &&
+                       ((screenX >= windowFromX && screenX < windowToX) ||
+                        line[screenX] != 0);
+      if (!isCovered) {
+        line[screenX] = spriteColors[screenX];
+      }
+    }
+  }
+}
+
+auto GPU::currentLineInputs() const -> LineInputs {
+  return {
+      .registers = {io_memory[LCDC], io_memory[BG_SCY], io_memory[BG_SCX],
+                    io_memory[WINDOW_Y], io_memory[WINDOW_X],
+                    io_memory[BG_Palette], io_memory[O0_Palette],
+                    io_memory[O1_Palette]},
+      .windowOffsetY = windowOffsetY,
+      .drawnAt = displayWrites,
+      .isDrawn = true,
+  };
+}
+
+auto GPU::isLineUnchanged(int screenY, const LineInputs& inputs) const
+    -> bool {
+  /*
+  Returns true if the line 'screenY' of the front buffer was drawn from the
+  same registers, and none of the map row, tiles and sprites it used were
+  written since. Mirrors the layers drawn by drawLine.
+  */
+  const LineInputs& drawn = frameInputs[backBuffer ^ 1U][screenY];
+  if (!drawn.isDrawn || drawn.registers != inputs.registers ||
+      drawn.windowOffsetY != inputs.windowOffsetY) {
+    return false;
+  }
+
+  const uint64_t since = drawn.drawnAt;
+  if ((io_memory[LCDC] & 0x01U) != 0 &&
+      isMapLineChanged(0, SCREEN_WIDTH, io_memory[BG_SCX],
+                       screenY + io_memory[BG_SCY], io_memory[LCDC] & 0x08U,
+                       since)) {
+    return false;
+  }
+
+  int windowY = windowOffsetY - io_memory[WINDOW_Y];
+  if ((io_memory[LCDC] & 0x20U) != 0 && io_memory[WINDOW_X] <= 166 &&
+      windowY >= 0 && windowY < SCREEN_HEIGHT) {
+    int windowStart = io_memory[WINDOW_X] - 7;
+    int windowFromX = std::max(0, windowStart);
+    int windowToX = std::min<int>(SCREEN_WIDTH, windowStart + SCREEN_WIDTH);
+    if (isMapLineChanged(windowFromX, windowToX, windowFromX - windowStart,
+                         windowY, io_memory[LCDC] & 0x40U, since)) {
+      return false;
+    }
+  }
+
+  return (io_memory[LCDC] & 0x02U) == 0 ||
+         !isSpriteLineChanged(screenY, since);
+}
+
+auto GPU::isMapLineChanged(int fromX,
+                           int toX,
+                           uint8_t mapX,
+                           uint8_t mapY,
+                           bool map2,
+                           uint64_t since) const -> bool {
+  /*
+  Returns true if the map row or a tile that renderMapLine would draw with the
+  same arguments was written after 'since'.
+  */
+  const size_t map = map2 ? 1 : 0;
+  if (mapRowWrittenAt[(map * 0x20) + (mapY / 8)] > since) {
+    return true;
+  }
+
+  const auto& mapRow = backgroundMaps[map][mapY / 8];
+  int screenX = fromX;
+  while (screenX < toX) {
+    uint16_t tileIndex = mapRow[mapX / 8];
+    if ((io_memory[LCDC] & 0x10U) == 0) {
+      tileIndex = 0x100 + (int8_t)(tileIndex & 0xFFU);
+    }
+    if (tileWrittenAt[tileIndex] > since) {
+      return true;
     }
-    if ((io_memory[LCDC] & 0x20U) != 0 &&
-        windowOverridesPixel(screenX, screenY, pixelColor)) {
-      frontend.addPixel(pixelColor, screenX, screenY);
+    const int count = std::min(8 - (mapX % 8), toX - screenX);
+    screenX += count;
+    mapX += count;
+  }
+  return false;
+}
+
+auto GPU::isSpriteLineChanged(int screenY, uint64_t since) const -> bool {
+  /*
+  Returns true if OAM, or the tiles of a sprite on the line, were written
+  after 'since'. Checks every sprite on the line, not only the 10 drawn.
+  */
+  if (spritesWrittenAt > since) {
+    return true;
+  }
+
+  uint8_t height = 8 + ((io_memory[LCDC] & 0x04U) << 1U);
+  for (const SpriteAttribute& attribs : sprites) {
+    if ((attribs.y > screenY + 16) || (attribs.y + height <= screenY + 16)) {
       continue;
     }
-    if ((io_memory[LCDC] & 0x01U) != 0) {
-      backgroundPixel(screenX, screenY, pixelColor);
+    // 16px sprites use both tiles of the pair, whichever row is drawn
+    uint8_t tileIndex = attribs.tile;
+    if ((io_memory[LCDC] & 0x04U) != 0) {
+      tileIndex = attribs.tile & 0xFEU;
+      if (tileWrittenAt[tileIndex + 1] > since) {
+        return true;
+      }
+    }
+    if (tileWrittenAt[tileIndex] > since) {
+      return true;
     }
-    frontend.addPixel(pixelColor, screenX, screenY);
   }
+  return false;
 }
 
 auto GPU::setLCDStage(uint8_t stage, bool interrupt) -> bool {
@@ -242,8 +479,11 @@ auto GPU::updateLCD(IOFrontend& frontend) -> bool {
           if (setLCDStage(0x00, io_memory[LCD_STAT] & 0x08U)) {
             // Only attempt draw once per line
             // Only draw when frame requested
-            if (frontend.isFrameScheduled()) {
-              renderLine(frontend);
+            if (io_memory[LCD_LY] == 0) {
+              isRenderingFrame = isFrameRendered(frontend);
+            }
+            if (isRenderingFrame) {
+              renderLine();
             }
           }
           break;
@@ -254,11 +494,18 @@ auto GPU::updateLCD(IOFrontend& frontend) -> bool {
       if (setLCDStage(0x01U, io_memory[LCD_STAT] & 0x10U)) {
         // Always trigger vsync interrupt
         io_memory[INTERRUPTS] |= VSYNC_INTERRUPT;
+        vblankCount += 1;
       }
       break;
     default:
       // VBlank finished... flush screen
-      frontend.commitRender();
+      if (isRenderingFrame) {
+        frontend.commitRender(frameBuffers[backBuffer]);
+        backBuffer ^= 1U;
+      } else {
+        frontend.commitSkippedFrame(frameBuffers[backBuffer ^ 1U]);
+      }
+      isRenderingFrame = false;
       // Reset registers
       io_memory[LCD_LY] = 0;
       vCycleCount = 0;
@@ -268,43 +515,144 @@ auto GPU::updateLCD(IOFrontend& frontend) -> bool {
   return false;
 }
 
-auto GPU::spriteOverridesPixel(int screenX, int screenY, uint8_t& color) const
-    -> bool {
+auto GPU::cyclesUntilNextEvent() const -> uint64_t {
+  /*
+  Returns the number of cycles until updateLCD next changes the LCD state.
+  Zero if the LCD registers are out of date and need updating immediately.
+  */
+  if ((io_memory[LCDC] & 0x80U) == 0) {
+    // Disabled LCD restarts its timing on every update: keep updating so it
+    // starts from the instruction that re-enables it.
+    return 0;
+  }
+
+  const uint64_t lineStart = vCycleCount - (vCycleCount % 456);
+  uint8_t stage = 0;
+  uint64_t nextChange = 0;
+  switch (vCycleCount) {
+    case 0 ... 65663:
+      switch (vCycleCount % 456) {
+        case 0 ... 77:
+          stage = 0x02U;
+          nextChange = lineStart + 78;
+          break;
+        case 78 ... 246:
+          stage = 0x03U;
+          nextChange = lineStart + 247;
+          break;
+        default:
+          stage = 0x00U;
+          nextChange = lineStart + 456;
+          break;
+      }
+      break;
+    case 65664 ... 70223:
+      // LY still increments every line during vblank
+      stage = 0x01U;
+      nextChange = lineStart + 456;
+      break;
+    default:
+      // Frame finished
+      return 0;
+  }
+
+  if ((io_memory[LCD_STAT] & 0x03U) != stage ||
+      io_memory[LCD_LY] != vCycleCount / 456) {
+    return 0;
+  }
+  // vCycleCount runs 4 times faster than the cpu cycle
+  return (nextChange - vCycleCount + 3) / 4;
+}
+
+auto GPU::decodeStaleTiles() -> void {
+  /*
+  Brings 'decodedTiles' up to date with every tile written since the last line
+  was drawn. Games rarely write more than a few tiles per frame.
+  */
+  if (staleTiles.none()) {
+    return;
+  }
+  for (size_t tile = 0; tile < patternTables.size(); tile++) {
+    if (!staleTiles.test(tile)) {
+      continue;
+    }
+    for (size_t row = 0; row < 8; row++) {
+      decodedTiles[tile][row] = decode_tile_row(patternTables[tile][row][0],
+                                                patternTables[tile][row][1]);
+    }
+  }
+  staleTiles.reset();
+}
+
+auto GPU::renderMapLine(Line line,
+                        int fromX,
+                        int toX,
+                        uint8_t mapX,
+                        uint8_t mapY,
+                        bool map2) const -> void {
+  /*
+  Draws the background map pixels starting at (mapX, mapY) into line[fromX,
+  toX), the map wraps every 256 pixels. Each tile row is palette mapped once.
+  When map2 == False: backgroundMap1 is used for tile resolution
+  When map2 == True: backgroundMap2 is used for tile resolution
+  */
+  const auto& mapRow = backgroundMaps[map2 ? 1 : 0][mapY / 8];
+  const uint8_t palette = io_memory[BG_Palette];
+
+  int screenX = fromX;
+  while (screenX < toX) {
+    // Read tile index from correct background map
+    uint16_t tileIndex = mapRow[mapX / 8];
+
+    // Correct index using the signed lookup table if requested
+    if ((io_memory[LCDC] & 0x10U) == 0) {
+      tileIndex = 0x100 + (int8_t)(tileIndex & 0xFFU);
+    }
+
+    // Gets the true background colors of the visible part of the tile row
+    const PixelRow colors =
+        apply_palette(decodedTiles[tileIndex][mapY % 8], palette);
+    const uint8_t tileX = mapX % 8;
+    const int count = std::min(8 - tileX, toX - screenX);
+    store_row(colors, line.subspan(screenX, count), tileX);
+    screenX += count;
+    mapX += count;
+  }
+}
+
+auto GPU::renderSpriteLine(int screenY,
+                           Line colors,
+                           std::array<bool, SCREEN_WIDTH>& isVisible,
+                           std::array<bool, SCREEN_WIDTH>& isBehindBackground)
+    const -> void {
   /*
-  Uses the sprite attributes and pattern data to set &color
-  If this color is definitely in the forground, returns true.
-  If no color can be found or the color is transparent, color is not modified
+  Draws the sprites on the current line into colors.
+  Where sprites overlap, the first sprite in OAM has priority.
+  isVisible is set for non-transparent sprite pixels and isBehindBackground
+  if that sprite's attribute 7 gives the background priority.
   */
   // Set to 8 of 16 height mode
   uint8_t height = 8 + ((io_memory[LCDC] & 0x04U) << 1U);
 
-  // Sprites are enabled, draw them
-  size_t sprites_on_scanline = 0;
+  // The PPU selects up to 10 objects sequentially from OAM
+  std::array<const SpriteAttribute*, 10> selected = {};
+  size_t selectedCount = 0;
   for (const SpriteAttribute& attribs : sprites) {
     if ((attribs.y > screenY + 16) || (attribs.y + height <= screenY + 16)) {
       continue;
     }
-
-    sprites_on_scanline += 1;
-    if (sprites_on_scanline > 10) {
-      // The PPU selects up to 10 objects sequentially from OAM
-      continue;
+    selected[selectedCount++] = &attribs;
+    if (selectedCount == selected.size()) {
+      break;
     }
+  }
 
-    // Check if sprite contains x coord
-    if ((attribs.x > screenX + 8) || (attribs.x <= screenX)) {
-      continue;
-    }
+  // Draw in reverse so the first sprite in OAM ends up on top
+  for (size_t i = selectedCount; i-- > 0;) {
+    const SpriteAttribute& attribs = *selected[i];
 
-    // Pixel is definitely in current sprite
     // Get relative tile coord
-    uint8_t tileX = (8 + screenX) - attribs.x;
     uint8_t tileY = (16 + screenY) - attribs.y;
-
-    // Mirror patterns if attrib is set
-    if ((attribs.attribs & 0x20U) != 0) {
-      tileX = 7 - tileX;
-    }
     if ((attribs.attribs & 0x40U) != 0) {
       tileY = height - tileY;
     }
@@ -316,88 +664,29 @@ auto GPU::spriteOverridesPixel(int screenX, int screenY, uint8_t& color) const
       tileIndex = (attribs.tile & 0xFEU) + (uint8_t)(tileY > 7U);
     }
 
-    // Extract color from tile and color palette
-    const Tile& tile = patternTables[tileIndex];
-    bool upper = ((tile[tileY % 8][1] >> (7 - tileX)) & 1);
-    bool lower = ((tile[tileY % 8][0] >> (7 - tileX)) & 1);
-    uint8_t colorIndex = (upper << 1) | lower;
-
-    if (colorIndex == 0) {
-      continue;  // Sprite at this location is transparent
+    PixelRow indices = decodedTiles[tileIndex][tileY % 8];
+    if ((attribs.attribs & 0x20U) != 0) {
+      // Mirror patterns if attrib is set
+      indices = flip_row(indices);
     }
 
     // Select the color palette
-    uint8_t colorPalette =
-        io_memory[O0_Palette + ((attribs.attribs & 0x10U) >> 4U)];
-
-    // Sets color reference and returns
-    color = (colorPalette >> (2 * colorIndex)) & 0x03U;
-
-    // First sprite has draw priority so return immediately
-    return !(attribs.attribs &
-             0x80U);  // Attrib 7 determines forground priority
-  }
-  return false;
-}
-
-auto GPU::pixelFromMap(uint16_t mapX, uint16_t mapY, bool map2) const
-    -> uint8_t {
-  /*
-  Returns the pixel located at the corresponding map coordinates
-  When map2 == False: backgroundMap1 is used for tile resolution
-  When map2 == True: backgroundMap2 is used for tile resolution
-  */
-
-  // Read tile index from correct background map
-  uint16_t tileIndex = backgroundMaps[0][(mapY / 8) % 0x20][(mapX / 8) % 0x20];
-  if (map2) {
-    tileIndex = backgroundMaps[1][(mapY / 8) % 0x20][(mapX / 8) % 0x20];
-  }
+    const PixelRow spriteColors = apply_palette(
+        indices, io_memory[O0_Palette + ((attribs.attribs & 0x10U) >> 4U)]);
 
-  // Correct index using the signed lookup table if requested
-  if ((io_memory[LCDC] & 0x10U) == 0) {
-    tileIndex = 0x100 + (int8_t)(tileIndex & 0xFFU);
-  }
-
-  const Tile& tile = patternTables[tileIndex];
-  uint8_t upper = (tile[mapY % 8][1] >> (7 - mapX % 8)) & 1;
-  uint8_t lower = (tile[mapY % 8][0] >> (7 - mapX % 8)) & 1;
-  uint8_t colorIndex = (upper << 1U) + lower;
-
-  // Gets the true background color
-  return (io_memory[BG_Palette] >> (2 * colorIndex)) & 0x03U;
-}
-
-void GPU::backgroundPixel(int screenX, int screenY, uint8_t& color) const {
-  /*
-  Uses the background map and pattern data to set &color
-  If background color is zero, color is not modified
-  */
-  int bgX = screenX + io_memory[BG_SCX];
-  int bgY = screenY + io_memory[BG_SCY];
-
-  uint8_t bgColor = pixelFromMap(bgX, bgY, io_memory[LCDC] & 0x08U);
-  if (bgColor != 0) {
-    color = bgColor;
-  }
-}
-
-auto GPU::windowOverridesPixel(int screenX, int screenY, uint8_t& color) const
-    -> bool {
-  (void)screenY;
-  /*
-  Uses the window map and pattern data to set &color
-  Window is always drawn on top of background
-  */
-  int windowX = screenX - io_memory[WINDOW_X] + 7;
-  int windowY = windowOffsetY - io_memory[WINDOW_Y];
+    for (uint8_t tileX = 0; tileX < 8; tileX++) {
+      int screenX = attribs.x - 8 + tileX;
+      if (screenX < 0 || screenX >= SCREEN_WIDTH) {
+        continue;
+      }
+      if (row_pixel(indices, tileX) == 0) {
+        continue;  // Sprite at this location is transparent
+      }
 
-  if (io_memory[WINDOW_X] > 166) {
-    return false;
-  }
-  if (windowX >= 0 && windowX < 160 && windowY >= 0 && windowY < 144) {
-    color = pixelFromMap(windowX, windowY, io_memory[LCDC] & 0x40U);
-    return true;
+      colors[screenX] = row_pixel(spriteColors, tileX);
+      isVisible[screenX] = true;
+      // Attrib 7 determines forground priority
+      isBehindBackground[screenX] = (attribs.attribs & 0x80U) != 0;
+    }
   }
-  return false;
 }
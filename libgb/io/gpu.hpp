@@ -1,13 +1,35 @@
 #pragma once
 
+#include "../constants.hpp"
+#include "../error_handling.hpp"
+#include "../utils/save_state.hpp"
 #include "frontend.hpp"
+#include "tile_row.hpp"
 
 #include <array>
+#include <bitset>
 #include <cstdint>
 #include <span>
 
 namespace gb {
 
+enum class RenderMode : uint8_t {
+  every_frame,      // Whenever the frontend schedules a frame
+  every_nth_frame,  // Only frames whose index is a multiple of the interval
+  on_change,        // Only if VRAM, OAM or a display register was written
+  never,
+};
+
+struct RenderPolicy {
+  /*
+  Chooses which frames are drawn, on top of IOFrontend::isFrameScheduled.
+  Rendering has no side effects on the emulated hardware, so LCD timing and
+  interrupts are identical in every mode.
+  */
+  RenderMode mode = RenderMode::every_frame;
+  uint64_t interval = 1;  // For every_nth_frame
+};
+
 class GPU {
   /*
   Each tile is 16 bytes.
@@ -17,6 +39,8 @@ class GPU {
   // TODO: use mdspan here
   using Tile = std::array<std::array<uint8_t, 0x02>, 0x08>;
   using Background = std::array<std::array<uint8_t, 0x20>, 0x20>;
+  using Line = std::span<uint8_t, SCREEN_WIDTH>;
+  using FrameBuffer = std::array<uint8_t, SCREEN_WIDTH * SCREEN_HEIGHT>;
 
   struct SpriteAttribute {
     uint8_t y = 0;
@@ -26,24 +50,73 @@ class GPU {
   };
 
   std::span<uint8_t, 0x80> io_memory;
+  ErrorPolicy* errors;
 
   std::array<SpriteAttribute, 40> sprites = {};
   std::array<Tile, 0x180> patternTables = {};
 
+  // Color indices of every tile row, decoded from 'patternTables'. A write
+  // only marks its tile stale, it is decoded again before the next line is
+  // drawn. Derived state, it is not saved.
+  using DecodedTile = std::array<PixelRow, 8>;
+  std::array<DecodedTile, 0x180> decodedTiles = {};
+  std::bitset<0x180> staleTiles;
+
   std::array<Background, 2> backgroundMaps = {};
 
+  // Lines are drawn into the back buffer, the front buffer holds the last
+  // committed frame
+  std::array<FrameBuffer, 2> frameBuffers = {};
+  size_t backBuffer = 0;
+
+  // Every write that changes a tile, map row or OAM is numbered, so a line
+  // knows which of its inputs changed since it was drawn. Derived state, it is
+  // not saved.
+  uint64_t displayWrites = 0;
+  std::array<uint64_t, 0x180> tileWrittenAt = {};
+  std::array<uint64_t, 0x40> mapRowWrittenAt = {};  // 0x20 rows per map
+  uint64_t spritesWrittenAt = 0;
+
+  // What each line of a frame buffer was drawn from. A line that would be
+  // drawn from the same registers and unchanged memory as the same line of
+  // the front buffer is copied from it instead.
+  struct LineInputs {
+    std::array<uint8_t, 8> registers = {};  // LCDC, scroll, window, palettes
+    int32_t windowOffsetY = 0;
+    uint64_t drawnAt = 0;  // 'displayWrites' when the line was drawn
+    bool isDrawn = false;
+  };
+  using FrameInputs = std::array<LineInputs, SCREEN_HEIGHT>;
+  std::array<FrameInputs, 2> frameInputs = {};
+
   uint64_t vCycleCount = 0;
+  uint64_t vblankCount = 0;
   int32_t windowOffsetY = 0;
 
+  // Chosen by the frontend, not part of the save state
+  RenderPolicy renderPolicy;
+  // Decided at the start of each frame, saved with the frame in progress
+  bool isRenderingFrame = false;
+  bool isDisplayChanged = true;  // Since the last drawn frame started
+
  public:
-  explicit GPU(std::span<uint8_t, 0x80> io_memory);
+  GPU(std::span<uint8_t, 0x80> io_memory, ErrorPolicy& errors);
   auto reset() -> void;
 
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
+
   [[nodiscard]] auto readU8(uint16_t addr, bool is_dma) const -> uint8_t;
   auto writeU8(uint16_t addr, uint8_t value, bool is_dma) -> void;
 
   auto updateTimers(uint64_t dt) -> void;
   auto updateLCD(IOFrontend&) -> bool;
+  [[nodiscard]] auto cyclesUntilNextEvent() const -> uint64_t;
+  [[nodiscard]] auto frameCount() const -> uint64_t { return vblankCount; }
+
+  auto setRenderPolicy(RenderPolicy policy) -> void { renderPolicy = policy; }
+  // Called for writes to registers that change what is drawn
+  auto markDisplayChanged() -> void { isDisplayChanged = true; }
 
  private:
   [[nodiscard]] auto byteFromSpriteAttributes(uint16_t addr) const
@@ -53,18 +126,34 @@ class GPU {
   [[nodiscard]] auto byteFromBackgroundMaps(uint16_t addr) const
       -> uint8_t const&;
 
-  auto renderLine(IOFrontend&) -> void;
+  [[nodiscard]] auto isFrameRendered(IOFrontend&) -> bool;
+  auto renderLine() -> void;
+  auto drawLine(Line line, int screenY) const -> void;
+  [[nodiscard]] auto currentLineInputs() const -> LineInputs;
+  [[nodiscard]] auto isLineUnchanged(int screenY,
+                                     const LineInputs& inputs) const -> bool;
+  [[nodiscard]] auto isMapLineChanged(int fromX,
+                                      int toX,
+                                      uint8_t mapX,
+                                      uint8_t mapY,
+                                      bool map2,
+                                      uint64_t since) const -> bool;
+  [[nodiscard]] auto isSpriteLineChanged(int screenY, uint64_t since) const
+      -> bool;
   auto setLCDStage(uint8_t stage, bool interrupt) -> bool;
-  [[nodiscard]] auto spriteOverridesPixel(int screenX,
-                                          int screenY,
-                                          uint8_t& color) const -> bool;
-
-  [[nodiscard]] auto pixelFromMap(uint16_t mapX, uint16_t mapY, bool map2) const
-      -> uint8_t;
-  auto backgroundPixel(int screenX, int screenY, uint8_t& color) const -> void;
-  [[nodiscard]] auto windowOverridesPixel(int screenX,
-                                          int screenY,
-                                          uint8_t& color) const -> bool;
+
+  auto decodeStaleTiles() -> void;
+  auto renderMapLine(Line line,
+                     int fromX,
+                     int toX,
+                     uint8_t mapX,
+                     uint8_t mapY,
+                     bool map2) const -> void;
+  auto renderSpriteLine(
+      int screenY,
+      Line colors,
+      std::array<bool, SCREEN_WIDTH>& isVisible,
+      std::array<bool, SCREEN_WIDTH>& isBehindBackground) const -> void;
 };
 
 }  // namespace gb
@@ -18,8 +18,7 @@ class Headless : public IOFrontend {
 
   auto getKeyPressState() -> Key override { return Key::NONE; };
   auto sendSerial(uint8_t value) -> void override { *os << std::hex << value; };
-  auto addPixel(int, int, int) -> void override {};
-  auto commitRender() -> void override {};
+  auto commitRender(Frame) -> void override {};
   auto isFrameScheduled() -> bool override { return false; };
   auto isExitRequested() -> bool override { return false; };
 
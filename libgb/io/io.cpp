@@ -16,6 +16,31 @@ auto IO::reset() -> void {
   lastCycle = 0;
   tCycleCount = 0;
   cycle = 0;
+  scheduler.reset();
+}
+
+auto IO::saveState(StateWriter& writer) const -> void {
+  writer.write(memory);
+  writer.write(inputs);
+  writer.write(lastCycle);
+  writer.write(tCycleCount);
+  writer.write(dmaStartTime);
+  writer.write(cycle);
+  writer.write(scheduler);
+  gpu.saveState(writer);
+  apu.save_state(writer);
+}
+
+auto IO::loadState(StateReader& reader) -> void {
+  reader.read(memory);
+  reader.read(inputs);
+  reader.read(lastCycle);
+  reader.read(tCycleCount);
+  reader.read(dmaStartTime);
+  reader.read(cycle);
+  reader.read(scheduler);
+  gpu.loadState(reader);
+  apu.load_state(reader);
 }
 
 [[nodiscard]] auto IO::isInDMA() const -> bool {
@@ -52,7 +77,7 @@ auto IO::ioRead(uint16_t addr) -> uint8_t {
     case 0xFF46:
       // DMA - DMA Transfer and Start Address (W)
       // DMA reads are never allowed
-      throw_error([&] {
+      report_error(*errors, [&] {
         return IllegalMemoryAddress(
             std::format("DMA read (@ {:#06x}) not permitted!", addr));
       });
@@ -101,13 +126,23 @@ auto IO::ioWrite(uint16_t addr, uint8_t value) -> void {
       break;
     case 0xFF04:
       // DIV -- Divider Register (cannot write data)
-      throw std::runtime_error("DIV write unsupported");
+      report_error(*errors, [] {
+        return IllegalMemoryWrite("DIV write unsupported");
+      });
       break;
     case 0xFF05:
       // TIMA -- Timer counter (R/W)
       // Should only update timers between instructions when accessed
       updateTimers();
       memory[addr - IO_OFFSET] = value;
+      reschedule();
+      break;
+    case 0xFF07:
+      // TAC -- Timer control
+      // Time before the write still counts at the old frequency
+      updateTimers();
+      memory[addr - IO_OFFSET] = value;
+      reschedule();
       break;
 
     // Special LCD registers
@@ -115,22 +150,37 @@ auto IO::ioWrite(uint16_t addr, uint8_t value) -> void {
       if ((value & 0x80U) == 0 && (memory[addr - IO_OFFSET] & 0x80U) != 0) {
         // We're disable the LCD, this is only allowed in vblank video mode
         if ((memory[LCD_STAT] & 0b11U) != 1U) {
-          throw_error([] {
+          report_error(*errors, [] {
             return LCDDisableViolation(
                 "LCD must only be disabled during vblank");
           });
         }
       }
+      if (value != memory[addr - IO_OFFSET]) {
+        gpu.markDisplayChanged();
+      }
       memory[addr - IO_OFFSET] = value;
+      reschedule();
       break;
 
     case 0xFF41:
       // LCD Status Register
       memory[LCD_STAT] = 0x80U | (memory[LCD_STAT] & 0x07U) | (value & 0x78U);
       break;
+    case 0xFF42 ... 0xFF43:
+    case 0xFF47 ... 0xFF4B:
+      // Scroll, palettes and window position only change what is drawn
+      if (value != memory[addr - IO_OFFSET]) {
+        gpu.markDisplayChanged();
+      }
+      memory[addr - IO_OFFSET] = value;
+      break;
     case 0xFF44:
       // LY -- Scroll Y (r)
-      throw std::runtime_error("Cannot write to LY @ 0xFF44");
+      report_error(*errors, [] {
+        return IllegalMemoryWrite("Cannot write to LY @ 0xFF44");
+      });
+      break;
 
     case (IO_OFFSET + FIRST_APU_REGISTER)...(IO_OFFSET + LAST_APU_REGISTER):
       updateTimers();
@@ -159,44 +209,84 @@ auto IO::reduceTimer(uint16_t threshold) -> void {
   }
 }
 
-auto IO::updateTimers() -> void {
-  uint64_t dt = cycle - lastCycle;
-  lastCycle = cycle;
-
-  // Inc timer by real cycle time
-  gpu.updateTimers(dt);
-  tCycleCount += dt;
-  // Timer increments every 64 cycles
-  memory[DIV_TIMER] = (cycle / 64) % 0x100;
-  apu.clock_to(4 * cycle);
-
+auto IO::timerThreshold() const -> uint16_t {
+  /*
+  Returns the number of cycles per TIMA increment, or 0 if the timer is
+  disabled
+  */
   switch (memory[T_CONTROL] & 0x07U) {
     case 0x04:
       // 4096 Hz
-      reduceTimer(256);
-      break;
+      return 256;
     case 0x05:
       // 262144 Hz
-      reduceTimer(4);
-      break;
+      return 4;
     case 0x06:
       // 65536 Hz
-      reduceTimer(16);
-      break;
+      return 16;
     case 0x07:
       // 16384 Hz
-      reduceTimer(64);
-      break;
+      return 64;
     default:
       // Timer is disabled
-      break;
+      return 0;
   }
 }
 
+auto IO::updateTimers() -> void {
+  uint64_t dt = cycle - lastCycle;
+  lastCycle = cycle;
+
+  // Inc timer by real cycle time
+  gpu.updateTimers(dt);
+  tCycleCount += dt;
+  // Timer increments every 64 cycles
+  memory[DIV_TIMER] = (cycle / 64) % 0x100;
+  apu.clock_to(4 * cycle);
+
+  if (const auto threshold = timerThreshold(); threshold != 0) {
+    reduceTimer(threshold);
+  }
+}
+
+auto IO::reschedule() -> void {
+  /*
+  Registers the next cycle at which each component changes observable state.
+  Must be called whenever IO is updated or a register affecting these
+  deadlines is written.
+  */
+  if (const uint64_t lcdDelay = gpu.cyclesUntilNextEvent();
+      lcdDelay == Scheduler::NEVER) {
+    scheduler.schedule(Event::lcd, Scheduler::NEVER);
+  } else {
+    scheduler.schedule(Event::lcd, lastCycle + lcdDelay);
+  }
+
+  if (const uint64_t threshold = timerThreshold(); threshold != 0) {
+    // Cycles remaining before TIMA overflows and requests an interrupt
+    const uint64_t overflowAfter = (0x100U - memory[T_COUNTER]) * threshold;
+    const uint64_t delay =
+        overflowAfter > tCycleCount ? overflowAfter - tCycleCount : 0;
+    scheduler.schedule(Event::timer_overflow, lastCycle + delay);
+  } else {
+    scheduler.schedule(Event::timer_overflow, Scheduler::NEVER);
+  }
+
+  // The APU frame sequencer is clocked by the falling edge of DIV bit 4, every
+  // 2048 cycles. Each edge must be seen by a separate update.
+  constexpr uint64_t divApuPeriod = 2048;
+  scheduler.schedule(Event::div_apu,
+                     lastCycle - (lastCycle % divApuPeriod) + divApuPeriod);
+}
+
 auto IO::isSimulationFinished() -> bool {
   return frontend->isExitRequested();
 }
 
+auto IO::isRewindRequested() -> bool {
+  return frontend->isRewindRequested();
+}
+
 auto IO::update() -> void {
   updateTimers();
 
@@ -217,4 +307,6 @@ auto IO::update() -> void {
     }
     inputs = ~keyState;
   }
+
+  reschedule();
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "../error_handling.hpp"
+#include "../utils/save_state.hpp"
 #include "apu.hpp"
 #include "frontend.hpp"
 #include "gpu.hpp"
+#include "io_registers.hpp"
+#include "scheduler.hpp"
 
 #include <cstdint>
 #include <memory>
@@ -31,6 +35,8 @@ class IO {
   APU apu;
 
   std::unique_ptr<IOFrontend> frontend;
+  Scheduler scheduler;
+  ErrorPolicy* errors;
 
   // Inputs P14 (lower nibble) and P15 (upper nibble)
   uint8_t inputs = 0xFF;
@@ -42,13 +48,17 @@ class IO {
  public:
   uint64_t cycle = 0;
 
-  explicit IO(std::unique_ptr<IOFrontend> frontend)
-      : gpu(memory),
+  IO(std::unique_ptr<IOFrontend> frontend, ErrorPolicy& errors)
+      : gpu(memory, errors),
         apu(memory, frontend->get_approx_audio_sample_freq()),
-        frontend(std::move(frontend)) {}
+        frontend(std::move(frontend)),
+        errors(&errors) {}
 
   auto reset() -> void;
 
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
+
   [[nodiscard]] auto isInDMA() const -> bool;
   auto startDMA() -> void;
 
@@ -57,14 +67,42 @@ class IO {
   auto videoWrite(uint16_t addr, uint8_t value, bool is_dma = false) -> void;
 
   [[nodiscard]] auto ioRead(uint16_t addr) -> uint8_t;
+  [[nodiscard]] auto ioRead2(uint16_t addr) -> uint8_t;
   auto ioWrite(uint16_t addr, uint8_t value) -> void;
 
   auto isSimulationFinished() -> bool;
+  auto isRewindRequested() -> bool;
   auto update() -> void;
 
+  // IF register, read without going through the memory map
+  [[nodiscard]] auto interruptFlags() const -> uint8_t {
+    return memory[io_registers::INTERRUPTS];
+  }
+
+  // Number of VBlank periods entered since power on
+  [[nodiscard]] auto frameCount() const -> uint64_t {
+    return gpu.frameCount();
+  }
+
+  auto setRenderPolicy(RenderPolicy policy) -> void {
+    gpu.setRenderPolicy(policy);
+  }
+
+  // IO only needs updating once the next scheduled event is due
+  [[nodiscard]] auto isUpdateDue() const -> bool {
+    return cycle >= scheduler.next();
+  }
+
+  // Cycle of the next scheduled event, nothing observable changes before it
+  [[nodiscard]] auto nextUpdateCycle() const -> uint64_t {
+    return scheduler.next();
+  }
+
  private:
   auto updateTimers() -> void;
   auto reduceTimer(uint16_t threshold) -> void;
+  [[nodiscard]] auto timerThreshold() const -> uint16_t;
+  auto reschedule() -> void;
 };
 
 }  // namespace gb
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace gb {
+
+enum class Event : uint8_t {
+  lcd,             // GPU mode/ line change
+  timer_overflow,  // TIMA wraps and requests an interrupt
+  div_apu,         // DIV bit 4 falling edge, clocks the APU frame sequencer
+  _last,
+};
+static constexpr auto event_count = static_cast<size_t>(Event::_last);
+
+class Scheduler {
+  /*
+  Keeps the cycle timestamp at which each IO component next needs attention.
+  Between deadlines nothing observable changes, so the CPU can keep running
+  without updating IO.
+  */
+  std::array<uint64_t, event_count> deadlines = {};
+  uint64_t nextDeadline = 0;
+
+ public:
+  static constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+  auto reset() -> void {
+    deadlines.fill(0);
+    nextDeadline = 0;
+  }
+
+  auto schedule(Event event, uint64_t cycle) -> void {
+    deadlines[static_cast<size_t>(event)] = cycle;
+    nextDeadline = std::ranges::min(deadlines);
+  }
+
+  [[nodiscard]] auto next() const -> uint64_t { return nextDeadline; }
+};
+
+}  // namespace gb
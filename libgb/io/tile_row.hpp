@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace gb {
+
+/*
+A row of 8 pixels packed one per byte into a uint64_t, leftmost pixel in the
+lowest byte. Decoding and palette mapping work on all 8 pixels at once with
+plain 64-bit arithmetic, so no per-target code or dispatch is needed.
+*/
+using PixelRow = uint64_t;
+
+namespace detail {
+// Byte i of SPREAD_BITS[x] is bit (7 - i) of x
+constexpr auto SPREAD_BITS = [] {
+  std::array<PixelRow, 0x100> table = {};
+  for (size_t x = 0; x < table.size(); x++) {
+    for (size_t i = 0; i < 8; i++) {
+      table[x] |= (PixelRow)((x >> (7 - i)) & 1U) << (8 * i);
+    }
+  }
+  return table;
+}();
+
+constexpr PixelRow ONES = 0x0101010101010101ULL;
+}  // namespace detail
+
+// Color indices (0-3) of a tile row from its two bitplane bytes
+[[nodiscard]] constexpr auto decode_tile_row(uint8_t lower, uint8_t upper)
+    -> PixelRow {
+  return detail::SPREAD_BITS[lower] | (detail::SPREAD_BITS[upper] << 1U);
+}
+
+// Looks up every color index in a BGP/OBP style palette register
+[[nodiscard]] constexpr auto apply_palette(PixelRow indices, uint8_t palette)
+    -> PixelRow {
+  using detail::ONES;
+  const PixelRow low = indices & ONES;
+  const PixelRow high = (indices >> 1U) & ONES;
+  // Exactly one of these bytes is set per pixel, so the products never carry
+  return ((~low & ~high & ONES) * (palette & 0x03U)) +
+         ((low & ~high) * ((palette >> 2U) & 0x03U)) +
+         ((~low & high) * ((palette >> 4U) & 0x03U)) +
+         ((low & high) * ((palette >> 6U) & 0x03U));
+}
+
+// Mirrors a row horizontally (sprite attribute bit 5)
+[[nodiscard]] constexpr auto flip_row(PixelRow row) -> PixelRow {
+  return std::byteswap(row);
+}
+
+[[nodiscard]] constexpr auto row_pixel(PixelRow row, size_t x) -> uint8_t {
+  return (uint8_t)(row >> (8 * x));
+}
+
+// Writes the pixels [from, from + out.size()) of a row
+constexpr auto store_row(PixelRow row, std::span<uint8_t> out, size_t from = 0)
+    -> void {
+  if (std::endian::native == std::endian::little && from == 0 &&
+      out.size() == 8) {
+    // Whole rows are already in screen order
+    std::ranges::copy(std::bit_cast<std::array<uint8_t, 8>>(row), out.begin());
+    return;
+  }
+  for (size_t i = 0; i < out.size(); i++) {
+    out[i] = row_pixel(row, from + i);
+  }
+}
+
+static_assert(decode_tile_row(0x80, 0x01) == 0x0200000000000001ULL);
+static_assert(apply_palette(0x0302010003020100ULL, 0xE4) ==
+              0x0302010003020100ULL);
+static_assert(apply_palette(0x0302010003020100ULL, 0x1B) ==
+              0x0001020300010203ULL);
+
+}  // namespace gb
@@ -9,11 +9,26 @@
 
 using namespace gb;
 
-MemoryMap::MemoryMap(Cartridge& cartridge, IO& io)
-    : cartridge{&cartridge}, io{&io} {
+MemoryMap::MemoryMap(Cartridge& cartridge, IO& io, ErrorPolicy& errors)
+    : cartridge{&cartridge}, io{&io}, errors{&errors} {
+  // Work ram and its echo (up to 0xFDFF, the last page is shared with OAM)
+  pages.mapRam(0xC000, 0x2000, workingRam.data());
+  pages.mapRam(0xE000, 0x1E00, workingRam.data());
+  cartridge.attach(pages, io.cycle, errors);
+
   reset();
 }
 
+auto MemoryMap::saveState(StateWriter& writer) const -> void {
+  writer.write(stack);
+  writer.write(workingRam);
+}
+
+auto MemoryMap::loadState(StateReader& reader) -> void {
+  reader.read(stack);
+  reader.read(workingRam);
+}
+
 void MemoryMap::reset() {
   stack = {};
   workingRam = {};
@@ -56,7 +71,7 @@ void MemoryMap::reset() {
 
 void MemoryMap::DMA(uint8_t srcUpper) {
   if (srcUpper > 0xF1U) {
-    throw_error([&] {
+    report_error(*errors, [&] {
       return IllegalMemoryAddress(std::format(
           "Invalid upper address for DMA Transfer {:#06x}", srcUpper));
     });
@@ -71,7 +86,7 @@ void MemoryMap::DMA(uint8_t srcUpper) {
   }
 }
 
-auto MemoryMap::read(uint16_t addr, bool is_dma) const -> Byte {
+auto MemoryMap::readSlow(uint16_t addr, bool is_dma) const -> Byte {
   switch (addr) {
     case 0x0000 ... 0x7FFF:
       // Rom
@@ -93,7 +108,7 @@ auto MemoryMap::read(uint16_t addr, bool is_dma) const -> Byte {
       return Byte{io->videoRead(addr, is_dma)};
     case 0xFEA0 ... 0xFEFF:
       // Not Usable
-      throw_error([&] {
+      report_error(*errors, [&] {
         return IllegalMemoryAddress(
             std::format("Unusable memory address {:#06x}", addr));
       });
@@ -108,7 +123,7 @@ auto MemoryMap::read(uint16_t addr, bool is_dma) const -> Byte {
       // Interrupts enabled Register
       return stack[0x7F];
     default:
-      throw_error([&] {
+      report_error(*errors, [&] {
         return IllegalMemoryAddress(
             std::format("Bad memory address {:#06x}", addr));
       });
@@ -116,7 +131,7 @@ auto MemoryMap::read(uint16_t addr, bool is_dma) const -> Byte {
   }
 }
 
-auto MemoryMap::write(uint16_t addr, Byte value, bool is_dma) -> void {
+auto MemoryMap::writeSlow(uint16_t addr, Byte value, bool is_dma) -> void {
   switch (addr) {
     case 0x0000 ... 0x7FFF:
       // Rom
@@ -164,7 +179,7 @@ auto MemoryMap::write(uint16_t addr, Byte value, bool is_dma) -> void {
       stack[0x7F] = value;
       break;
     default:
-      throw_error([&] {
+      report_error(*errors, [&] {
         return IllegalMemoryAddress(
             std::format("Bad memory address {:#06x}", addr));
       });
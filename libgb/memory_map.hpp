@@ -1,6 +1,9 @@
 #pragma once
 
+#include "error_handling.hpp"
+#include "page_table.hpp"
 #include "utils/checked_int.hpp"
+#include "utils/save_state.hpp"
 
 #include <array>
 #include <cstdint>
@@ -14,20 +17,58 @@ class MemoryMap {
  private:
   Cartridge* cartridge;
   IO* io;
+  ErrorPolicy* errors;
 
   // Inline the simple memories
   std::array<Byte, 0x80> stack = {};
   std::array<Byte, 0x2000> workingRam = {};
 
+  // Direct pointers for ROM/RAM pages, everything else takes the slow path
+  PageTable pages;
+
   void DMA(uint8_t srcUpper);
 
+  [[nodiscard]] auto readSlow(uint16_t addr, bool is_dma) const -> Byte;
+  auto writeSlow(uint16_t addr, Byte value, bool is_dma) -> void;
+
  public:
-  MemoryMap(Cartridge& cartridge, IO& io);
+  MemoryMap(Cartridge& cartridge, IO& io, ErrorPolicy& errors);
+  // The page table points into this object
+  MemoryMap(const MemoryMap&) = delete;
+  auto operator=(const MemoryMap&) -> MemoryMap& = delete;
 
   auto reset() -> void;
 
-  [[nodiscard]] auto read(uint16_t addr, bool is_dma = false) const -> Byte;
-  auto write(uint16_t addr, Byte value, bool is_dma = false) -> void;
+  auto saveState(StateWriter&) const -> void;
+  auto loadState(StateReader&) -> void;
+
+  [[nodiscard]] auto read(uint16_t addr, bool is_dma = false) const -> Byte {
+    if (const uint8_t* rom = pages.rom[addr >> 8U]; rom != nullptr) {
+      return Byte{rom[addr & 0xFFU]};
+    }
+    if (const Byte* ram = pages.ram[addr >> 8U]; ram != nullptr) {
+      return ram[addr & 0xFFU];
+    }
+    return readSlow(addr, is_dma);
+  }
+
+  // IE register (0xFFFF), which shares storage with high ram
+  [[nodiscard]] auto interruptEnable() const -> Byte { return stack[0x7F]; }
+
+  // Host memory behind 'addr' if it is mapped ROM, otherwise null. Valid until
+  // the next bank switch.
+  [[nodiscard]] auto romData(uint16_t addr) const -> const uint8_t* {
+    const uint8_t* rom = pages.rom[addr >> 8U];
+    return rom == nullptr ? nullptr : &rom[addr & 0xFFU];
+  }
+
+  auto write(uint16_t addr, Byte value, bool is_dma = false) -> void {
+    if (Byte* ram = pages.ram[addr >> 8U]; ram != nullptr) {
+      ram[addr & 0xFFU] = value;
+      return;
+    }
+    writeSlow(addr, value, is_dma);
+  }
 };
 
 }  // namespace gb
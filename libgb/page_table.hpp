@@ -0,0 +1,44 @@
+#pragma once
+
+#include "utils/checked_int.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gb {
+
+// Host pointers for every 256-byte page of the address space.
+// A null entry means the page must go through the slow path (IO, VRAM/OAM,
+// MBC registers, unmapped banks...).
+struct PageTable {
+  static constexpr size_t PAGE_SIZE = 0x100;
+  static constexpr size_t PAGE_COUNT = 0x100;
+
+  // Read-only pages (cartridge ROM)
+  std::array<const uint8_t*, PAGE_COUNT> rom = {};
+  // Read/write pages (work RAM, cartridge RAM)
+  std::array<Byte*, PAGE_COUNT> ram = {};
+
+  auto mapRom(uint16_t start, size_t size, const uint8_t* data) -> void {
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+      const size_t page = (start + offset) / PAGE_SIZE;
+      rom[page] = data == nullptr ? nullptr : data + offset;
+      ram[page] = nullptr;
+    }
+  }
+
+  auto mapRam(uint16_t start, size_t size, Byte* data) -> void {
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+      const size_t page = (start + offset) / PAGE_SIZE;
+      ram[page] = data == nullptr ? nullptr : data + offset;
+      rom[page] = nullptr;
+    }
+  }
+
+  auto unmap(uint16_t start, size_t size) -> void {
+    mapRom(start, size, nullptr);
+  }
+};
+
+}  // namespace gb
@@ -0,0 +1,167 @@
+#include "rewind.hpp"
+#include "gb.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+
+using namespace gb;
+
+RewindBuffer::RewindBuffer(size_t byte_budget, size_t keyframe_interval)
+    : keyframeInterval(std::max<size_t>(keyframe_interval, 1)),
+      storage(byte_budget / sizeof(uint64_t)) {}
+
+auto RewindBuffer::bytesUsed() const -> size_t {
+  size_t words = 0;
+  for (const auto& entry : entries) {
+    words += entry.size;
+  }
+  return words * sizeof(uint64_t);
+}
+
+auto RewindBuffer::capture(const GB& gameboy) -> void {
+  /*
+  The state grows with the call stack tracked by the CPU. Scratch buffers only
+  ever grow, the unused tail is left as zeros which encodes to nothing. Deltas
+  must be the same size as their keyframe, so growing starts a new keyframe.
+  */
+  const size_t bytes = gameboy.saveStateSize();
+  const size_t words = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  bool is_keyframe =
+      entries.empty() || capturesSinceKeyframe >= keyframeInterval;
+  if (words > state.size()) {
+    state.resize(words);
+    keyframe.resize(words);
+    zeros.resize(words);
+    encoded.resize(words + 1);
+    is_keyframe = true;
+  }
+
+  auto state_bytes = std::as_writable_bytes(std::span{state});
+  std::ranges::fill(state_bytes.subspan(gameboy.saveState(state_bytes)),
+                    std::byte{0});
+  store(is_keyframe);
+}
+
+auto RewindBuffer::store(bool is_keyframe) -> void {
+  /*
+  Encodes 'state' XOR the base as a list of tokens. Each token is a header word
+  holding the number of unchanged words (high half) and changed words (low
+  half), followed by the XOR of the changed words.
+  */
+  const auto& base = is_keyframe ? zeros : keyframe;
+  size_t size = 0;
+  size_t index = 0;
+  while (index < state.size()) {
+    const size_t unchanged_start = index;
+    while (index < state.size() && state[index] == base[index]) {
+      index++;
+    }
+    const size_t changed_start = index;
+    while (index < state.size() && state[index] != base[index]) {
+      index++;
+    }
+
+    encoded[size++] = ((uint64_t)(changed_start - unchanged_start) << 32U) |
+                      (uint64_t)(index - changed_start);
+    for (size_t i = changed_start; i < index; i++) {
+      encoded[size++] = state[i] ^ base[i];
+    }
+  }
+
+  const size_t offset = reserve(size);
+  if (not is_keyframe && entries.empty()) {
+    // Making space dropped the keyframe this delta depends on
+    store(true);
+    return;
+  }
+
+  std::ranges::copy(std::span{encoded}.first(size), storage.begin() + offset);
+  entries.push_back(
+      {.offset = offset, .size = size, .isKeyframe = is_keyframe});
+  if (is_keyframe) {
+    keyframe = state;
+    capturesSinceKeyframe = 0;
+  }
+  capturesSinceKeyframe += 1;
+}
+
+auto RewindBuffer::reserve(size_t words) -> size_t {
+  /*
+  Returns the offset of 'words' free words after the newest entry, wrapping to
+  the start of the ring when they do not fit at the end. Entries in the way
+  are dropped oldest first, along with any deltas left without a keyframe.
+  */
+  if (words > storage.size()) {
+    throw std::length_error("Rewind budget cannot hold a single frame");
+  }
+
+  size_t head = 0;
+  if (not entries.empty()) {
+    head = entries.back().offset + entries.back().size;
+  }
+  if (head + words > storage.size()) {
+    // The oldest entries are the ones past the newest, they are abandoned
+    while (not entries.empty() && entries.front().offset >= head) {
+      entries.pop_front();
+    }
+    head = 0;
+  }
+
+  while (not entries.empty() && entries.front().offset < head + words &&
+         head < entries.front().offset + entries.front().size) {
+    entries.pop_front();
+  }
+  while (not entries.empty() && not entries.front().isKeyframe) {
+    entries.pop_front();
+  }
+  return head;
+}
+
+auto RewindBuffer::decode(const Entry& entry,
+                          std::span<const uint64_t> base,
+                          std::span<uint64_t> out) const -> void {
+  size_t index = 0;
+  size_t position = entry.offset;
+  while (position < entry.offset + entry.size) {
+    const uint64_t header = storage[position++];
+    const size_t unchanged_end = index + (header >> 32U);
+    const size_t changed_end = unchanged_end + (header & 0xFFFF'FFFFU);
+
+    std::ranges::copy(base.subspan(index, unchanged_end - index),
+                      out.begin() + (ptrdiff_t)index);
+    for (index = unchanged_end; index < changed_end; index++) {
+      out[index] = base[index] ^ storage[position++];
+    }
+  }
+  std::ranges::copy(base.subspan(index), out.begin() + (ptrdiff_t)index);
+}
+
+auto RewindBuffer::rewind(GB& gameboy) -> bool {
+  if (entries.empty()) {
+    return false;
+  }
+
+  const Entry entry = entries.back();
+  entries.pop_back();
+  decode(entry, entry.isKeyframe ? zeros : keyframe, state);
+  gameboy.loadState(std::as_bytes(std::span{state}));
+
+  if (not entry.isKeyframe) {
+    capturesSinceKeyframe -= 1;
+    return true;
+  }
+
+  // Later captures continue the chain of the previous keyframe
+  const auto previous = std::ranges::find_if(
+      entries.rbegin(), entries.rend(),
+      [](const Entry& candidate) { return candidate.isKeyframe; });
+  if (previous != entries.rend()) {
+    decode(*previous, zeros, keyframe);
+    capturesSinceKeyframe = (size_t)(previous - entries.rbegin()) + 1;
+  }
+  return true;
+}
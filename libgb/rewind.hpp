@@ -0,0 +1,59 @@
+#pragma once
+
+#include "gb.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace gb {
+
+class RewindBuffer {
+  /*
+  Keeps recent save states in a fixed size ring of 64-bit words. Every
+  'keyframeInterval' captures the whole state is stored, the captures in
+  between only store how they differ from that keyframe. Both are run length
+  encoded XORs (a keyframe against zero), so unchanged memory costs almost
+  nothing. The oldest captures are dropped to stay within the byte budget.
+  */
+  struct Entry {
+    size_t offset;  // In words, into 'storage'
+    size_t size;    // In words
+    bool isKeyframe;
+  };
+
+  size_t keyframeInterval;
+  size_t capturesSinceKeyframe = 0;
+
+  std::vector<uint64_t> storage;
+  std::deque<Entry> entries;
+
+  // Raw state of the newest keyframe in 'entries', deltas are relative to it
+  std::vector<uint64_t> keyframe;
+  std::vector<uint64_t> zeros;
+
+  // Scratch space, sized on the first capture
+  std::vector<uint64_t> state;
+  std::vector<uint64_t> encoded;
+
+  auto reserve(size_t words) -> size_t;
+  auto store(bool is_keyframe) -> void;
+  auto decode(const Entry& entry, std::span<const uint64_t> base,
+              std::span<uint64_t> out) const -> void;
+
+ public:
+  explicit RewindBuffer(size_t byte_budget, size_t keyframe_interval = 60);
+
+  // Call once per frame
+  auto capture(const GB& gameboy) -> void;
+
+  // Restores the newest capture and forgets it, false if there is none left
+  auto rewind(GB& gameboy) -> bool;
+
+  [[nodiscard]] auto captureCount() const -> size_t { return entries.size(); }
+  [[nodiscard]] auto bytesUsed() const -> size_t;
+};
+
+}  // namespace gb
@@ -0,0 +1,96 @@
+#include "rom_image.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+using namespace gb;
+
+auto RomImage::mapFile(std::string_view path) -> RomImage {
+#ifdef __unix__
+  const int file = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    throw std::runtime_error("Couldn't open ROM");
+  }
+
+  struct stat info = {};
+  if (fstat(file, &info) != 0 || info.st_size == 0) {
+    close(file);
+    throw std::runtime_error(std::format("Couldn't read ROM '{}'", path));
+  }
+
+  // The mapping keeps its own reference to the file
+  const auto size = (size_t)info.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error(std::format("Couldn't map ROM '{}'", path));
+  }
+
+  RomImage image;
+  image.mapping = mapping;
+  image.mappingSize = size;
+  image.data = {static_cast<const uint8_t*>(mapping), size};
+  return image;
+#else
+  std::ifstream input(std::string(path), std::ios::binary | std::ios::ate);
+  if (!input) {
+    throw std::runtime_error("Couldn't open ROM");
+  }
+
+  std::vector<uint8_t> rom((size_t)input.tellg());
+  input.seekg(0);
+  input.read(reinterpret_cast<char*>(rom.data()), (std::streamsize)rom.size());
+  return own(std::move(rom));
+#endif
+}
+
+auto RomImage::borrow(std::span<const uint8_t> rom) -> RomImage {
+  RomImage image;
+  image.data = rom;
+  return image;
+}
+
+auto RomImage::own(std::vector<uint8_t> rom) -> RomImage {
+  RomImage image;
+  image.owned = std::move(rom);
+  image.data = image.owned;
+  return image;
+}
+
+RomImage::RomImage(RomImage&& other) noexcept
+    : data(std::exchange(other.data, {})),
+      owned(std::move(other.owned)),
+      mapping(std::exchange(other.mapping, nullptr)),
+      mappingSize(std::exchange(other.mappingSize, 0)) {}
+
+auto RomImage::operator=(RomImage&& other) noexcept -> RomImage& {
+  std::swap(data, other.data);
+  std::swap(owned, other.owned);
+  std::swap(mapping, other.mapping);
+  std::swap(mappingSize, other.mappingSize);
+  return *this;
+}
+
+RomImage::~RomImage() {
+#ifdef __unix__
+  if (mapping != nullptr) {
+    munmap(mapping, mappingSize);
+  }
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace gb {
+
+class RomImage {
+  /*
+  Read-only cartridge ROM. Files are memory mapped rather than read, so
+  loading is instant and every instance running the same ROM shares the same
+  physical pages. The bytes can also be borrowed from the caller, or owned
+  when they were generated in memory.
+  */
+  std::span<const uint8_t> data;
+  std::vector<uint8_t> owned;
+  void* mapping = nullptr;
+  size_t mappingSize = 0;
+
+  RomImage() = default;
+
+ public:
+  static auto mapFile(std::string_view path) -> RomImage;
+  // 'rom' must outlive the image (and any emulator using it)
+  static auto borrow(std::span<const uint8_t> rom) -> RomImage;
+  static auto own(std::vector<uint8_t> rom) -> RomImage;
+
+  RomImage(const RomImage&) = delete;
+  auto operator=(const RomImage&) -> RomImage& = delete;
+  RomImage(RomImage&& other) noexcept;
+  auto operator=(RomImage&& other) noexcept -> RomImage&;
+  ~RomImage();
+
+  [[nodiscard]] auto bytes() const -> std::span<const uint8_t> { return data; }
+  [[nodiscard]] auto size() const -> size_t { return data.size(); }
+  [[nodiscard]] auto operator[](size_t index) const -> uint8_t {
+    return data[index];
+  }
+};
+
+}  // namespace gb
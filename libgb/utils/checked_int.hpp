@@ -4,19 +4,53 @@
 
 #include <cassert>
 #include <compare>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <type_traits>
 
 namespace gb {
 
-template <std::integral Underlying, typename Decorated>
+// Building with -DGB_UNCHECKED_INTS (see libgb-fast.a in the Makefile) turns
+// off undefined/derived-from-sp tracking: Byte and Word then compile down to
+// their underlying integer and every sanitizer check folds away.
+#ifdef GB_UNCHECKED_INTS
+static constexpr bool checked_ints_by_default = false;
+#else
+static constexpr bool checked_ints_by_default = true;
+#endif
+
+// Stand-in for a tracking flag in unchecked builds: takes no space and always
+// reads as false. Each flag gets its own id so they can share an address.
+template <size_t id>
+struct UncheckedFlag {
+  constexpr UncheckedFlag() = default;
+  constexpr UncheckedFlag(bool) {}
+  template <size_t other_id>
+  constexpr UncheckedFlag(UncheckedFlag<other_id>) {}
+
+  constexpr operator bool() const { return false; }
+};
+
+template <bool checked, size_t id>
+using FlagBit = std::conditional_t<checked, bool, UncheckedFlag<id>>;
+
+template <std::integral Underlying,
+          typename Decorated,
+          bool checked = checked_ints_by_default>
 struct CheckedInt {
-  struct Flags {
+  struct CheckedFlags {
     bool derived_from_sp : 1;
     bool undefined : 1;
   };
+  struct UncheckedFlags {
+    [[no_unique_address]] UncheckedFlag<0> derived_from_sp;
+    [[no_unique_address]] UncheckedFlag<1> undefined;
+  };
+  using Flags = std::conditional_t<checked, CheckedFlags, UncheckedFlags>;
+
   Underlying data;
-  Flags flags;
+  [[no_unique_address]] Flags flags;
 
   constexpr CheckedInt()
       : data{0}, flags{.derived_from_sp = false, .undefined = true} {}
@@ -27,7 +61,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto decay() const -> Underlying {
     if (flags.undefined) {
-      throw_error([&] {
+      report_value_error([&] {
         return UndefinedDataError("Attempt to decay undefined byte");
       });
     }
@@ -41,7 +75,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator+(Decorated other) const -> Decorated {
     if (flags.undefined || other.flags.undefined) {
-      throw_error(
+      report_value_error(
           [&] { return UndefinedDataError("Attempt to add undefined byte"); });
     }
     bool derived_from_sp = flags.derived_from_sp || other.flags.derived_from_sp;
@@ -54,7 +88,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator-(Decorated other) const -> Decorated {
     if (flags.undefined || other.flags.undefined) {
-      throw_error(
+      report_value_error(
           [&] { return UndefinedDataError("Attempt to sub undefined byte"); });
     }
     bool derived_from_sp = flags.derived_from_sp || other.flags.derived_from_sp;
@@ -67,7 +101,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator|(Decorated other) const -> Decorated {
     if (flags.undefined || other.flags.undefined) {
-      throw_error(
+      report_value_error(
           [&] { return UndefinedDataError("Attempt to or undefined byte"); });
     }
     bool derived_from_sp = flags.derived_from_sp || other.flags.derived_from_sp;
@@ -86,7 +120,7 @@ struct CheckedInt {
         (not other.flags.undefined && not flags.undefined);
 
     if (not is_well_defined) {
-      throw_error(
+      report_value_error(
           [&] { return UndefinedDataError("Attempt to and undefined byte"); });
     }
     bool derived_from_sp = flags.derived_from_sp || other.flags.derived_from_sp;
@@ -99,7 +133,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator^(Decorated other) const -> Decorated {
     if (flags.undefined || other.flags.undefined) {
-      throw_error(
+      report_value_error(
           [&] { return UndefinedDataError("Attempt to xor undefined byte"); });
     }
     bool derived_from_sp = flags.derived_from_sp || other.flags.derived_from_sp;
@@ -112,7 +146,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator~() const -> Decorated {
     if (flags.undefined) {
-      throw_error([&] {
+      report_value_error([&] {
         return UndefinedDataError("Attempt to negate undefined byte");
       });
     }
@@ -125,7 +159,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator>>(size_t amount) const -> Decorated {
     if (flags.undefined) {
-      throw_error([&] {
+      report_value_error([&] {
         return UndefinedDataError("Attempt to rshift undefined byte");
       });
     }
@@ -138,7 +172,7 @@ struct CheckedInt {
 
   [[nodiscard]] constexpr auto operator<<(size_t amount) const -> Decorated {
     if (flags.undefined) {
-      throw_error([&] {
+      report_value_error([&] {
         return UndefinedDataError("Attempt to lshift undefined byte");
       });
     }
@@ -157,7 +191,7 @@ struct CheckedInt {
   [[nodiscard]] constexpr auto operator<=>(const CheckedInt& other) const
       -> std::strong_ordering {
     if (flags.undefined || other.flags.undefined) {
-      throw_error([&] {
+      report_value_error([&] {
         return UndefinedDataError("Attempt to compare undefined byte");
       });
     }
@@ -171,8 +205,10 @@ struct Byte : CheckedInt<uint8_t, Byte> {
 
 // Special case, can be split up into potentially undefined bytes
 struct Word : CheckedInt<uint16_t, Word> {
-  bool high_undefined = false;
-  bool low_undefined = false;
+  [[no_unique_address]] FlagBit<checked_ints_by_default, 2> high_undefined =
+      false;
+  [[no_unique_address]] FlagBit<checked_ints_by_default, 3> low_undefined =
+      false;
 
   using CheckedInt::CheckedInt;
 
@@ -200,6 +236,9 @@ struct Word : CheckedInt<uint16_t, Word> {
   }
 };
 
+static_assert(checked_ints_by_default || sizeof(Byte) == sizeof(uint8_t));
+static_assert(checked_ints_by_default || sizeof(Word) == sizeof(uint16_t));
+
 constexpr auto operator""_B(unsigned long long data) -> Byte {
   assert(data <= std::numeric_limits<uint8_t>::max());
   return Byte{static_cast<uint8_t>(data)};
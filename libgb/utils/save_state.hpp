@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace gb {
+
+/*
+Save states are the raw bytes of each component's state, copied block by block.
+Only trivially copyable objects may be written, so every field is a single
+memcpy. Readers must consume blocks in the same order they were written.
+*/
+template <typename T>
+concept SaveStateBlock = std::is_trivially_copyable_v<T>;
+
+class StateWriter {
+  std::span<std::byte> buffer;
+  size_t offset = 0;
+  bool measureOnly = false;
+
+ public:
+  // Counts the bytes that would be written, without writing anything
+  StateWriter() : measureOnly(true) {}
+  explicit StateWriter(std::span<std::byte> buffer) : buffer(buffer) {}
+
+  auto writeBytes(const void* data, size_t size) -> void {
+    if (!measureOnly) {
+      if (size > buffer.size() - offset) {
+        throw std::length_error(std::format(
+            "Save state needs more than {} bytes", buffer.size()));
+      }
+      std::memcpy(&buffer[offset], data, size);
+    }
+    offset += size;
+  }
+
+  template <SaveStateBlock T>
+  auto write(const T& value) -> void {
+    writeBytes(&value, sizeof(T));
+  }
+
+  template <SaveStateBlock T>
+  auto write(const std::vector<T>& values) -> void {
+    write(values.size());
+    writeBytes(values.data(), values.size() * sizeof(T));
+  }
+
+  [[nodiscard]] auto size() const -> size_t { return offset; }
+};
+
+class StateReader {
+  std::span<const std::byte> buffer;
+  size_t offset = 0;
+
+ public:
+  explicit StateReader(std::span<const std::byte> buffer) : buffer(buffer) {}
+
+  auto readBytes(void* data, size_t size) -> void {
+    if (size > buffer.size() - offset) {
+      throw std::runtime_error("Save state is truncated");
+    }
+    std::memcpy(data, &buffer[offset], size);
+    offset += size;
+  }
+
+  template <SaveStateBlock T>
+  auto read(T& value) -> void {
+    readBytes(&value, sizeof(T));
+  }
+
+  template <SaveStateBlock T>
+  auto read(std::vector<T>& values) -> void {
+    size_t count = 0;
+    read(count);
+    if (count > (buffer.size() - offset) / sizeof(T)) {
+      throw std::runtime_error("Save state is truncated");
+    }
+    values.resize(count);
+    readBytes(values.data(), count * sizeof(T));
+  }
+
+  [[nodiscard]] auto size() const -> size_t { return offset; }
+};
+
+}  // namespace gb
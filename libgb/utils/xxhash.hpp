@@ -0,0 +1,94 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace gb {
+
+namespace detail {
+constexpr uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t XXH_PRIME3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+constexpr auto xxh_read64(std::span<const uint8_t> bytes, size_t at)
+    -> uint64_t {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; i++) {
+    value |= (uint64_t)bytes[at + i] << (8 * i);
+  }
+  return value;
+}
+
+constexpr auto xxh_read32(std::span<const uint8_t> bytes, size_t at)
+    -> uint64_t {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 4; i++) {
+    value |= (uint64_t)bytes[at + i] << (8 * i);
+  }
+  return value;
+}
+
+constexpr auto xxh_round(uint64_t acc, uint64_t input) -> uint64_t {
+  return std::rotl(acc + (input * XXH_PRIME2), 31) * XXH_PRIME1;
+}
+
+constexpr auto xxh_merge(uint64_t acc, uint64_t lane) -> uint64_t {
+  return ((acc ^ xxh_round(0, lane)) * XXH_PRIME1) + XXH_PRIME4;
+}
+}  // namespace detail
+
+// XXH64, matches the reference implementation for the same seed
+constexpr auto xxhash64(std::span<const uint8_t> bytes, uint64_t seed = 0)
+    -> uint64_t {
+  using namespace detail;
+  const size_t size = bytes.size();
+  size_t at = 0;
+  uint64_t hash = 0;
+
+  if (size >= 32) {
+    uint64_t lanes[4] = {seed + XXH_PRIME1 + XXH_PRIME2, seed + XXH_PRIME2,
+                         seed, seed - XXH_PRIME1};
+    for (; at + 32 <= size; at += 32) {
+      for (size_t lane = 0; lane < 4; lane++) {
+        lanes[lane] = xxh_round(lanes[lane], xxh_read64(bytes, at + 8 * lane));
+      }
+    }
+    hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) +
+           std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+    for (const uint64_t lane : lanes) {
+      hash = xxh_merge(hash, lane);
+    }
+  } else {
+    hash = seed + XXH_PRIME5;
+  }
+  hash += size;
+
+  for (; at + 8 <= size; at += 8) {
+    hash ^= xxh_round(0, xxh_read64(bytes, at));
+    hash = (std::rotl(hash, 27) * XXH_PRIME1) + XXH_PRIME4;
+  }
+  if (at + 4 <= size) {
+    hash ^= xxh_read32(bytes, at) * XXH_PRIME1;
+    hash = (std::rotl(hash, 23) * XXH_PRIME2) + XXH_PRIME3;
+    at += 4;
+  }
+  for (; at < size; at++) {
+    hash ^= bytes[at] * XXH_PRIME5;
+    hash = std::rotl(hash, 11) * XXH_PRIME1;
+  }
+
+  hash ^= hash >> 33U;
+  hash *= XXH_PRIME2;
+  hash ^= hash >> 29U;
+  hash *= XXH_PRIME3;
+  hash ^= hash >> 32U;
+  return hash;
+}
+
+static_assert(xxhash64({}) == 0xEF46DB3751D8E999ULL);
+
+}  // namespace gb
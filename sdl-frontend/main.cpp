@@ -1,5 +1,8 @@
+#include "../libgb/cartridge.hpp"
 #include "../libgb/gb.hpp"
+#include "../libgb/io/capture.hpp"
 #include "../libgb/io/headless.hpp"
+#include "../libgb/rewind.hpp"
 
 #include "sdl_io.hpp"
 
@@ -20,6 +23,9 @@ auto main(int argc, char** argv) -> int {
   std::optional<std::string_view> rom;
   bool is_gui = false;
   bool permissive = false;
+  size_t rewind_budget_mb = 64;
+  std::optional<gb::CaptureOptions> capture;
+  std::optional<uint64_t> capture_interval;
 
   // Headless is a flag
   if (auto gui_flag = std::ranges::find(args, std::string_view{"--gui"});
@@ -35,6 +41,37 @@ auto main(int argc, char** argv) -> int {
     args.erase(permissive_flag);
   }
 
+  if (auto rewind_flag =
+          std::ranges::find(args, std::string_view{"--rewind-budget"});
+      rewind_flag != args.end()) {
+    const auto budget_it = rewind_flag + 1;
+    rewind_budget_mb = std::stoul(std::string{*budget_it});
+    args.erase(rewind_flag, budget_it + 1);
+  }
+
+  // Frames are written as PNGs to a directory or streamed raw to a file/pipe
+  for (const auto& [flag, format] : {
+           std::pair{std::string_view{"--capture-png"}, gb::CaptureFormat::png},
+           std::pair{std::string_view{"--capture-raw"}, gb::CaptureFormat::raw},
+       }) {
+    if (auto capture_flag = std::ranges::find(args, flag);
+        capture_flag != args.end()) {
+      const auto path_it = capture_flag + 1;
+      capture = gb::CaptureOptions{.format = format,
+                                   .path = std::string{*path_it}};
+      args.erase(capture_flag, path_it + 1);
+    }
+  }
+
+  // Only capture every n-th frame
+  if (auto every_flag =
+          std::ranges::find(args, std::string_view{"--capture-every"});
+      every_flag != args.end()) {
+    const auto interval_it = every_flag + 1;
+    capture_interval = std::stoull(std::string{*interval_it});
+    args.erase(every_flag, interval_it + 1);
+  }
+
   // Listen is named and implies gdb server mode
   if (auto listen_flag = std::ranges::find(args, std::string_view{"--listen"});
       listen_flag != args.end()) {
@@ -78,6 +115,14 @@ auto main(int argc, char** argv) -> int {
     frontend = std::make_unique<gb::Headless>(std::cout);
   }
 
+  gb::CaptureFrontend* capture_frontend = nullptr;
+  if (capture.has_value()) {
+    auto wrapped =
+        std::make_unique<gb::CaptureFrontend>(std::move(frontend), *capture);
+    capture_frontend = wrapped.get();
+    frontend = std::move(wrapped);
+  }
+
   // Run
   if (port.has_value()) {
     gb::run_gdb_server(*port, std::move(frontend), rom);
@@ -85,7 +130,26 @@ auto main(int argc, char** argv) -> int {
     if (not rom.has_value()) {
       throw std::runtime_error("Argument error: missing position argument ROM");
     }
-    auto gameboy = std::make_unique<gb::GB>(rom.value(), std::move(frontend));
-    gb::run_standalone(*gameboy);
+    // Battery backed RAM is kept next to the ROM
+    auto gameboy = std::make_unique<gb::GB>(
+        gb::Cartridge::loadFromRom(*rom, gb::Cartridge::savePathFor(*rom)),
+        std::move(frontend));
+    if (capture_interval.has_value()) {
+      gameboy->io.setRenderPolicy(
+          {gb::RenderMode::every_nth_frame, *capture_interval});
+    }
+    if (is_gui && rewind_budget_mb != 0) {
+      // Hold R to rewind, the budget is in MiB
+      gb::RewindBuffer rewind{rewind_budget_mb << 20U};
+      gb::run_standalone(*gameboy, &rewind);
+    } else {
+      gb::run_standalone(*gameboy);
+    }
+
+    // Save the game before exiting
+    gameboy->flush();
+    if (capture_frontend != nullptr) {
+      capture_frontend->flush();
+    }
   }
 }
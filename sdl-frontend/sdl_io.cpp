@@ -28,9 +28,13 @@ static constexpr std::array<std::array<uint8_t, 3>, 5> colorsRGB{
      {{255, 0, 0}}}};
 
 namespace {
-auto rgb_to_uint32_t(const std::array<uint8_t, 3>& rgb) -> uint32_t {
+constexpr auto rgb_to_uint32_t(const std::array<uint8_t, 3>& rgb) -> uint32_t {
   return (rgb[0] << 0U) | (rgb[1] << 8U) | (rgb[2] << 16U) | (255U << 24U);
 }
+
+constexpr std::array<uint32_t, 4> colorsRGBA{
+    rgb_to_uint32_t(colorsRGB[0]), rgb_to_uint32_t(colorsRGB[1]),
+    rgb_to_uint32_t(colorsRGB[2]), rgb_to_uint32_t(colorsRGB[3])};
 }  // namespace
 
 SDLFrontend::SDLFrontend() : m_key_events{{gb::Key::NONE}} {
@@ -140,6 +144,9 @@ auto SDLFrontend::process_events() -> void {
         if (event.key.keysym.sym == SDLK_s) {
           m_speed_up_mode.store(true, std::memory_order_relaxed);
         }
+        if (event.key.keysym.sym == SDLK_r) {
+          m_rewind_mode.store(true, std::memory_order_relaxed);
+        }
 
         const auto pressed = map_to_GB_key(event.key.keysym.sym);
         if (m_last_keypress_was_down) {
@@ -155,6 +162,9 @@ auto SDLFrontend::process_events() -> void {
         if (event.key.keysym.sym == SDLK_s) {
           m_speed_up_mode.store(false, std::memory_order_relaxed);
         }
+        if (event.key.keysym.sym == SDLK_r) {
+          m_rewind_mode.store(false, std::memory_order_relaxed);
+        }
 
         const auto pressed = map_to_GB_key(event.key.keysym.sym);
         if (not m_last_keypress_was_down) {
@@ -231,14 +241,21 @@ auto SDLFrontend::sendSerial(uint8_t value) -> void {
   std::cout << std::hex << value;
 }
 
-auto SDLFrontend::addPixel(int color, int screenX, int screenY) -> void {
-  m_data_to_render[screenY * (m_render_stride / 4) + screenX] =
-      rgb_to_uint32_t(colorsRGB[color]);
-}
-
-auto SDLFrontend::commitRender() -> void {
+auto SDLFrontend::commitRender(gb::Frame frame) -> void {
   m_gb_frame_count += 1;
 
+  if (m_current_frame_is_visible) {
+    // Convert the finished frame into the locked texture in a single pass
+    for (size_t screenY = 0; screenY < gb::SCREEN_HEIGHT; screenY++) {
+      uint32_t* row = &m_data_to_render[screenY * (m_render_stride / 4)];
+      const auto colors = frame.subspan(screenY * gb::SCREEN_WIDTH,
+                                        gb::SCREEN_WIDTH);
+      for (size_t screenX = 0; screenX < gb::SCREEN_WIDTH; screenX++) {
+        row[screenX] = colorsRGBA[colors[screenX]];
+      }
+    }
+  }
+
   if (not m_speed_up_mode.load(std::memory_order_relaxed)) {
     m_current_frame_is_visible = true;
     m_data_to_render = nullptr;
@@ -268,6 +285,10 @@ auto SDLFrontend::isExitRequested() -> bool {
   return m_exit_requested.load(std::memory_order_relaxed);
 }
 
+auto SDLFrontend::isRewindRequested() -> bool {
+  return m_rewind_mode.load(std::memory_order_relaxed);
+}
+
 auto SDLFrontend::get_approx_audio_sample_freq() -> size_t {
   return m_audio_sample_frequency;
 }
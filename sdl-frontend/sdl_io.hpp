@@ -55,6 +55,7 @@ class SDLFrontend : public gb::IOFrontend {
   bool m_last_keypress_was_down = false;
 
   std::atomic<bool> m_speed_up_mode = false;
+  std::atomic<bool> m_rewind_mode = false;
   std::atomic<bool> m_exit_requested = false;
 
   // Diagnostics
@@ -75,10 +76,10 @@ class SDLFrontend : public gb::IOFrontend {
   auto getKeyPressState() -> gb::Key override;
   auto sendSerial(uint8_t value) -> void override;
 
-  auto addPixel(int color, int screenX, int screenY) -> void override;
-  auto commitRender() -> void override;
+  auto commitRender(gb::Frame frame) -> void override;
   auto isFrameScheduled() -> bool override;
   auto isExitRequested() -> bool override;
+  auto isRewindRequested() -> bool override;
 
   auto get_approx_audio_sample_freq() -> size_t override;
   auto try_flush_audio(std::span<std::pair<float, float>> samples)
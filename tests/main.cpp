@@ -1,11 +1,30 @@
+#include "libgb/batch.hpp"
 #include "libgb/cartridge.hpp"
 #include "libgb/error_handling.hpp"
 #include "libgb/gb.hpp"
+#include "libgb/io/capture.hpp"
 #include "libgb/io/headless.hpp"
+#include "libgb/page_table.hpp"
+#include "libgb/rewind.hpp"
+#include "libgb/utils/xxhash.hpp"
 
 #include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 const uint64_t FREQUENCY = 1048576UL;  // 4.194 MHz
 const double FRAMETIME = 1.0 / 59.7;   // 59.7 Hz
@@ -29,66 +48,68 @@ std::array<std::array<const char*, 2>, 14> testROMs = {
      {{"Blargg's Instructions Timing", "tests/instr_timing/instr_timing.gb"}},
      {{"Blargg's Memory Timing 1", "tests/mem_timing/mem_timing.gb"}}}};
 
-bool passesTest(const char* testROM) {
+auto testJob(const char* testROM) -> gb::BatchJob {
   /*
-  Returns a boolean: true if the test ROM passes.
+  Test ROMs are required to give serial output indicating failure status.
+  Output is checked every few CPU cycles, a ROM that hasn't passed or failed
+  within the budget probably got stuck in an infinite loop (or can't be
+  automated).
+  */
+  return {
+      .rom_path = testROM,
+      .inputs = {},
+      .cycle_budget = (1ULL << 13U) * 0x4000,
+      .permitted_errors = {},  // Same as main()
+      .stop_on_output = {"Passed", "Failed"},
+      .hash_frames = {},
+  };
+}
+
+bool passesTest(const gb::BatchResult& result) {
+  /*
+  Returns a boolean: true if the test ROM passed.
   Will also log failure info to console if available.
-  Test ROM is required to give serial output indicating failure status.
   - If the ROM gives no output before the timeout: return false
   - If the Emulator throws an exception:           return false
   - If the ROM outputs a failure code:             return false
   */
-
-  std::streamsize previousSize = 0;  // Used for timeout
-  std::stringstream output;
-
-  try {
-    gb::GB gb(testROM, std::make_unique<gb::Headless>(output));
-
-    for (unsigned i = 0; i < (1U << 25U); i++) {
-      gb.clock();
-
-      // Check output every few CPU cycles
-      if (i % 0x1000 == 0) {
-        // Check if test has already passed or failed
-        if (output.str().find("Passed") != std::string::npos) {
-          return true;
-        }
-        if (output.str().find("Failed") != std::string::npos) {
-          return false;
-        }
-
-        // If test's still generating output prevent timeout
-        std::streamsize currentSize = output.gcount();
-        if (currentSize != previousSize) {
-          previousSize = currentSize;
-          i = 0;
-        }
-      }
-    }
-    // Test probably got stuck in an infinite loop (or can't be automated)
-    throw std::runtime_error("ROM timeout");  // Give an error hint
-  } catch (const std::exception& e) {
-    std::cerr << e.what() << " -- ";
+  if (result.error.has_value()) {
+    std::cerr << *result.error << " -- ";
+    return false;
+  }
+  if (result.reason != gb::StopReason::budget_exhausted) {
+    std::cerr << "ROM stopped unexpectedly -- ";
     return false;
   }
+  if (not result.matched_output.has_value()) {
+    std::cerr << "ROM timeout -- ";  // Give an error hint
+    return false;
+  }
+  return *result.matched_output == 0;
 }
 
 bool passesAllTests() {
   /*
-  Runs through all automated test ROMs and lists their status.
+  Runs all automated test ROMs in parallel and lists their status.
   Returns true if all tests pass.
   Automated ROMs are required to give a serial output and run in headless mode.
   */
+  std::vector<gb::BatchJob> jobs;
+  for (auto testROM : testROMs) {
+    jobs.push_back(testJob(testROM[1]));
+  }
+
+  std::cout << "Running test ROMs..." << std::endl;
+  const auto results = gb::run_batch(jobs);
+
   int testsRan = 0;
   int testsPassed = 0;
-  std::cout << "Running test ROMs..." << std::endl;
-  for (auto testROM : testROMs) {
+  for (size_t i = 0; i < testROMs.size(); i++) {
     testsRan++;
     std::cout << "  " << std::left << std::setw(30);  // Align to grid
-    std::cout << testROM[0] << ": " << std::flush;    // Prints the active test
+    std::cout << testROMs[i][0] << ": " << std::flush;  // Prints the test
 
-    if (passesTest(testROM[1])) {
+    if (passesTest(results[i])) {
       testsPassed++;
       std::cout << "Passed" << std::endl;
       continue;
@@ -105,6 +126,687 @@ bool passesAllTests() {
   return false;
 }
 
+// Frames 0, interval, 2 * interval... below 'frames' are hashed and compared
+// against the manifest
+struct GoldenROM {
+  const char* path;
+  uint64_t frames;
+  uint64_t interval;
+};
+
+std::array<GoldenROM, 3> goldenROMs = {{
+    {"tests/cpu_instrs/cpu_instrs.gb", 3300, 10},
+    {"tests/instr_timing/instr_timing.gb", 120, 1},
+    {"tests/mem_timing/mem_timing.gb", 180, 1},
+}};
+
+const char* GOLDEN_MANIFEST = "tests/golden_frames.txt";
+
+using GoldenHashes = std::map<std::pair<std::string, uint64_t>, uint64_t>;
+
+auto goldenJob(const GoldenROM& rom) -> gb::BatchJob {
+  /*
+  Only the hashed frames are drawn, the rest of the run costs the same as a
+  serial test. The LCD can be off for a while, so the budget has some slack.
+  */
+  gb::BatchJob job = {
+      .rom_path = rom.path,
+      .inputs = {},
+      .cycle_budget = 2 * rom.frames * gb::CYCLES_PER_FRAME,
+      .permitted_errors = {},  // Same as main()
+      .stop_on_output = {},
+      .hash_frames = {},
+  };
+  for (uint64_t frame = 0; frame < rom.frames; frame += rom.interval) {
+    job.hash_frames.push_back(frame);
+  }
+  return job;
+}
+
+auto runGoldenROMs() -> GoldenHashes {
+  /*
+  Hashes the chosen frames of every golden ROM in parallel. Frames that a ROM
+  didn't reach are left out.
+  */
+  std::vector<gb::BatchJob> jobs;
+  for (const auto& rom : goldenROMs) {
+    jobs.push_back(goldenJob(rom));
+  }
+  const auto results = gb::run_batch(jobs);
+
+  GoldenHashes hashes;
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (results[i].error.has_value()) {
+      std::cerr << jobs[i].rom_path << ": " << *results[i].error << std::endl;
+    }
+    for (size_t frame = 0; frame < results[i].frame_hashes.size(); frame++) {
+      hashes[{jobs[i].rom_path, jobs[i].hash_frames[frame]}] =
+          results[i].frame_hashes[frame];
+    }
+  }
+  return hashes;
+}
+
+auto readGoldenManifest() -> GoldenHashes {
+  // One '<frame> <hash> <rom path>' per line, # starts a comment
+  GoldenHashes hashes;
+  std::ifstream manifest(GOLDEN_MANIFEST);
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    uint64_t frame = 0;
+    uint64_t hash = 0;
+    std::string path;
+    fields >> frame >> std::hex >> hash >> std::ws;
+    std::getline(fields, path);
+    hashes[{path, frame}] = hash;
+  }
+  return hashes;
+}
+
+bool updateGoldenFrames() {
+  /*
+  Replaces the manifest with the frames drawn by this build. Only run this
+  after checking that the new frames are correct.
+  */
+  const auto hashes = runGoldenROMs();
+  std::ofstream manifest(GOLDEN_MANIFEST, std::ios::trunc);
+  manifest << "# Golden frame hashes (xxhash64), regenerate with "
+              "tests.out --update-goldens\n";
+  for (const auto& [key, hash] : hashes) {
+    manifest << key.second << ' ' << std::hex << std::setw(16)
+             << std::setfill('0') << hash << std::dec << std::setfill(' ')
+             << ' ' << key.first << '\n';
+  }
+  if (!manifest) {
+    std::cerr << "Couldn't write " << GOLDEN_MANIFEST << std::endl;
+    return false;
+  }
+  std::cout << "Updated " << hashes.size() << " golden frames" << std::endl;
+  return true;
+}
+
+bool matchesGoldenFrames() {
+  /*
+  Compares the chosen frames of every golden ROM against the manifest and
+  lists the first mismatch of each ROM.
+  Returns true if every frame is in the manifest and matches.
+  */
+  std::cout << "Checking golden frames..." << std::endl;
+  const auto expected = readGoldenManifest();
+  const auto actual = runGoldenROMs();
+
+  bool allMatch = true;
+  for (const auto& rom : goldenROMs) {
+    size_t checked = 0;
+    std::optional<std::string> mismatch;
+    for (uint64_t frame = 0; frame < rom.frames; frame += rom.interval) {
+      const auto golden = expected.find({rom.path, frame});
+      const auto drawn = actual.find({rom.path, frame});
+      checked++;
+      if (mismatch.has_value()) {
+        continue;
+      }
+      if (golden == expected.end()) {
+        mismatch = std::format("frame {} isn't in the manifest", frame);
+      } else if (drawn == actual.end()) {
+        mismatch = std::format("frame {} wasn't reached", frame);
+      } else if (golden->second != drawn->second) {
+        mismatch = std::format("frame {} differs", frame);
+      }
+    }
+
+    std::cout << "  " << std::left << std::setw(30);  // Align to grid
+    std::cout << rom.path << ": ";
+    if (mismatch.has_value()) {
+      allMatch = false;
+      std::cerr << *mismatch << std::endl;
+      continue;
+    }
+    std::cout << checked << " frames match" << std::endl;
+  }
+  std::cout << std::endl;
+
+  if (!allMatch) {
+    std::cerr << "Golden frames differ! If the change is intended, run "
+                 "tests.out --update-goldens"
+              << std::endl;
+  }
+  return allMatch;
+}
+
+// Schedules every other frame and records the hash of each frame it is given
+// for a scheduled frame, drawn or skipped
+class AlternatingFrontend : public gb::Headless {
+  std::vector<size_t>* hashes;
+  bool isScheduled = false;
+
+  auto record(gb::Frame frame) -> void {
+    if (isScheduled) {
+      hashes->push_back(std::hash<std::string_view>{}(
+          {(const char*)frame.data(), frame.size()}));
+    }
+  }
+
+ public:
+  AlternatingFrontend(std::ostream& serialOut, std::vector<size_t>& hashes)
+      : Headless(serialOut), hashes(&hashes) {}
+
+  auto commitRender(gb::Frame frame) -> void override { record(frame); }
+  auto commitSkippedFrame(gb::Frame last) -> void override { record(last); }
+  auto isFrameScheduled() -> bool override {
+    isScheduled = !isScheduled;
+    return isScheduled;
+  }
+};
+
+bool skipsOnlyUnchangedFrames() {
+  /*
+  Runs a ROM that writes to the display while every other frame is
+  unscheduled. The scheduled frames must be the same whether they are all
+  drawn or only drawn when the display changed, including changes made during
+  the unscheduled frames.
+  Returns true if both runs give the same frames.
+  */
+  auto scheduledFrames = [](gb::RenderMode mode) {
+    std::stringstream serialOut;
+    std::vector<size_t> hashes;
+    gb::GB gb("tests/cpu_instrs/cpu_instrs.gb",
+              std::make_unique<AlternatingFrontend>(serialOut, hashes));
+    gb.io.setRenderPolicy({.mode = mode, .interval = 1});
+    gb.runFrames(600);
+    return hashes;
+  };
+
+  std::cout << "Checking on_change rendering..." << std::endl;
+  const auto expected = scheduledFrames(gb::RenderMode::every_frame);
+  const auto actual = scheduledFrames(gb::RenderMode::on_change);
+  if (expected != actual) {
+    std::cerr << "  on_change drew a stale frame" << std::endl << std::endl;
+    return false;
+  }
+  std::cout << "  " << expected.size() << " scheduled frames match" << std::endl
+            << std::endl;
+  return true;
+}
+
+// Schedules every frame and records the hash of each one it is given
+class HashingFrontend : public gb::Headless {
+  std::vector<size_t>* hashes;
+
+ public:
+  HashingFrontend(std::ostream& serialOut, std::vector<size_t>& hashes)
+      : Headless(serialOut), hashes(&hashes) {}
+
+  auto commitRender(gb::Frame frame) -> void override {
+    hashes->push_back(std::hash<std::string_view>{}(
+        {(const char*)frame.data(), frame.size()}));
+  }
+  auto isFrameScheduled() -> bool override { return true; }
+};
+
+bool restoresSaveStates() {
+  /*
+  Saves a state part way through a ROM, runs on and then loads the state and
+  runs the same frames again. Both runs must draw the same frames, print the
+  same serial output and end with the same registers and cycle count.
+  Returns true if the runs match in every render mode.
+  */
+  constexpr uint64_t savedFrame = 300;
+  constexpr uint64_t replayedFrames = 300;
+
+  struct Run {
+    std::vector<size_t> hashes;
+    std::string serial;
+    std::tuple<uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t,
+               uint8_t, uint16_t, uint16_t, bool>
+        registers;
+    uint64_t cycle;
+    uint64_t instructions;
+
+    auto operator==(const Run&) const -> bool = default;
+  };
+
+  auto roundTrip = [](gb::RenderMode mode) {
+    std::stringstream serialOut;
+    std::vector<size_t> hashes;
+    gb::GB gb("tests/cpu_instrs/cpu_instrs.gb",
+              std::make_unique<HashingFrontend>(serialOut, hashes));
+    gb.io.setRenderPolicy({.mode = mode, .interval = 1});
+    gb.runFrames(savedFrame);
+
+    std::vector<std::byte> state(gb.saveStateSize());
+    gb.saveState(state);
+
+    auto replay = [&] {
+      hashes.clear();
+      serialOut.str("");
+      // The instruction count isn't saved, only the replayed ones are compared
+      const uint64_t instructions = gb.cpu.instructionCount();
+      gb.runFrames(replayedFrames);
+      const auto& r = gb.getCurrentRegisters();
+      return Run{
+          .hashes = hashes,
+          .serial = serialOut.str(),
+          .registers = {r.a.decay_or(0), r._f.decay_or(0), r.b.decay_or(0),
+                        r.c.decay_or(0), r.d.decay_or(0), r.e.decay_or(0),
+                        r.h.decay_or(0), r.l.decay_or(0), r.sp, r.pc, r.halt},
+          .cycle = gb.io.cycle,
+          .instructions = gb.cpu.instructionCount() - instructions,
+      };
+    };
+    const Run expected = replay();
+    gb.loadState(state);
+    const Run actual = replay();
+    return std::pair{expected, actual};
+  };
+
+  std::cout << "Checking save state round trips..." << std::endl;
+  bool allMatch = true;
+  for (const auto& [name, mode] :
+       {std::pair{"every_frame", gb::RenderMode::every_frame},
+        std::pair{"on_change", gb::RenderMode::on_change}}) {
+    const auto [expected, actual] = roundTrip(mode);
+    std::cout << "  " << std::left << std::setw(30);  // Align to grid
+    std::cout << name << ": ";
+    if (expected.hashes != actual.hashes) {
+      std::cerr << "frames differ after loading" << std::endl;
+    } else if (expected.serial != actual.serial) {
+      std::cerr << "serial output differs after loading" << std::endl;
+    } else if (expected != actual) {
+      std::cerr << "registers or cycle count differ after loading"
+                << std::endl;
+    } else {
+      std::cout << expected.hashes.size() << " frames match" << std::endl;
+      continue;
+    }
+    allMatch = false;
+  }
+  std::cout << std::endl;
+  return allMatch;
+}
+
+bool restoresRewoundStates() {
+  /*
+  Captures every frame into a rewind buffer too small to hold them all, so
+  the ring wraps and the oldest captures (and their orphaned deltas) are
+  dropped. Rewinds part way, captures again from there, then rewinds as far
+  as the buffer goes. Each restored state must match the state saved when it
+  was captured, byte for byte.
+  Returns true if every rewound state matches.
+  */
+  // About 50 frames without the sanitizer, far fewer with it
+  constexpr size_t budget = 64 << 10U;
+  constexpr size_t keyframeInterval = 8;
+
+  std::stringstream serialOut;
+  gb::GB gb("tests/cpu_instrs/cpu_instrs.gb",
+            std::make_unique<gb::Headless>(serialOut));
+  gb::RewindBuffer rewind{budget, keyframeInterval};
+
+  std::vector<std::vector<std::byte>> saved;
+  auto currentState = [&] {
+    std::vector<std::byte> state(gb.saveStateSize());
+    gb.saveState(state);
+    return state;
+  };
+  bool isEvicted = false;
+  auto captureFrames = [&](size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+      gb.runFrames(1);
+      const size_t count = rewind.captureCount();
+      rewind.capture(gb);
+      saved.push_back(currentState());
+      isEvicted = isEvicted || rewind.captureCount() <= count;
+    }
+  };
+  std::optional<std::string> mismatch;
+  auto rewindFrames = [&](size_t frames) {
+    size_t rewound = 0;
+    try {
+      while (rewound < frames && rewind.rewind(gb)) {
+        if (!mismatch.has_value() && currentState() != saved.back()) {
+          mismatch = std::format("capture {} differs", saved.size() - 1);
+        }
+        saved.pop_back();
+        rewound++;
+      }
+    } catch (const std::exception& e) {
+      // A corrupt capture doesn't load at all
+      mismatch = std::format("capture {}: {}", saved.size() - 1, e.what());
+    }
+    return rewound;
+  };
+
+  std::cout << "Checking rewind..." << std::endl;
+  captureFrames(120);
+  rewindFrames(20);
+  captureFrames(10);
+  const size_t retained = rewind.captureCount();
+  const size_t rewound = rewindFrames(saved.size());
+
+  std::cout << "  " << std::left << std::setw(30) << "ring buffer" << ": ";
+  if (mismatch.has_value()) {
+    std::cerr << *mismatch << std::endl << std::endl;
+    return false;
+  }
+  if (!isEvicted || rewound != retained || rewound == 0) {
+    std::cerr << std::format(
+                     "rewound {} of {} captures, {} were dropped", rewound,
+                     retained, isEvicted ? "some" : "none")
+              << std::endl
+              << std::endl;
+    return false;
+  }
+  std::cout << rewound << " rewound states match" << std::endl << std::endl;
+  return true;
+}
+
+bool capturesFrames() {
+  /*
+  Encodes a known frame as a PNG and compares it with the expected hash, then
+  streams the frames of a ROM to a raw capture file. The file must hold every
+  drawn frame, in order, 160x144 bytes each.
+  Returns true if both captures match.
+  */
+  std::cout << "Checking frame capture..." << std::endl;
+  bool allMatch = true;
+
+  // Stripes of every color, the PNG was checked with an independent decoder
+  constexpr uint64_t expectedPNG = 0x749d847c42102a02;
+  std::array<uint8_t, gb::SCREEN_WIDTH * gb::SCREEN_HEIGHT> pattern = {};
+  for (size_t y = 0; y < gb::SCREEN_HEIGHT; y++) {
+    for (size_t x = 0; x < gb::SCREEN_WIDTH; x++) {
+      pattern[y * gb::SCREEN_WIDTH + x] = ((x >> 3U) ^ (y >> 2U)) & 0x3U;
+    }
+  }
+  const uint64_t png = gb::xxhash64(gb::encode_png(pattern));
+  std::cout << "  " << std::left << std::setw(30) << "png" << ": ";
+  if (png != expectedPNG) {
+    allMatch = false;
+    std::cerr << std::format("hash is {:#018x}, expected {:#018x}", png,
+                             expectedPNG)
+              << std::endl;
+  } else {
+    std::cout << "encoded frame matches" << std::endl;
+  }
+
+  const auto rawPath =
+      std::filesystem::temp_directory_path() / "gb_capture_test.raw";
+  std::stringstream serialOut;
+  std::vector<size_t> hashes;
+  {
+    auto capture = std::make_unique<gb::CaptureFrontend>(
+        std::make_unique<HashingFrontend>(serialOut, hashes),
+        gb::CaptureOptions{.format = gb::CaptureFormat::raw,
+                           .path = rawPath.string()});
+    gb::CaptureFrontend& captured = *capture;
+    gb::GB gb("tests/cpu_instrs/cpu_instrs.gb", std::move(capture));
+    gb.runFrames(120);
+    captured.flush();
+  }
+
+  std::ifstream raw(rawPath, std::ios::binary);
+  const std::string bytes(std::istreambuf_iterator<char>(raw), {});
+  raw.close();
+  std::filesystem::remove(rawPath);
+
+  constexpr size_t frameSize = gb::SCREEN_WIDTH * gb::SCREEN_HEIGHT;
+  const std::string_view frames{bytes};
+  std::vector<size_t> written;
+  for (size_t at = 0; at + frameSize <= frames.size(); at += frameSize) {
+    written.push_back(
+        std::hash<std::string_view>{}(frames.substr(at, frameSize)));
+  }
+  std::cout << "  " << std::left << std::setw(30) << "raw" << ": ";
+  if (hashes.empty() || bytes.size() != hashes.size() * frameSize) {
+    allMatch = false;
+    std::cerr << std::format("wrote {} bytes for {} frames", bytes.size(),
+                             hashes.size())
+              << std::endl;
+  } else if (written != hashes) {
+    allMatch = false;
+    std::cerr << "written frames differ from the drawn ones" << std::endl;
+  } else {
+    std::cout << hashes.size() << " frames written" << std::endl;
+  }
+  std::cout << std::endl;
+  return allMatch;
+}
+
+auto syntheticROM(uint8_t controllerType, size_t banks) -> std::vector<uint8_t> {
+  // Every ROM bank starts with its own (little endian) number, the header
+  // declares 32KByte of RAM in 4 banks
+  std::vector<uint8_t> rom(banks * 0x4000);
+  for (size_t bank = 0; bank < banks; bank++) {
+    rom[bank * 0x4000] = bank & 0xFFU;
+    rom[bank * 0x4000 + 1] = bank >> 8U;
+  }
+  rom[0x147] = controllerType;
+  rom[0x149] = 0x03;
+  return rom;
+}
+
+bool switchesCartridgeBanks() {
+  /*
+  Drives MBC3 and MBC5 controllers of synthetic ROMs through their registers,
+  no test ROM uses either. Checks ROM and RAM bank selection (through the
+  cartridge and the page table) and the MBC3 real time clock, which is
+  advanced by moving the cycle counter.
+  Returns true if every controller behaves as expected.
+  */
+  using gb::operator""_B;
+  std::cout << "Checking cartridge controllers..." << std::endl;
+  bool allMatch = true;
+
+  gb::PageTable pages;
+  gb::ErrorPolicy errors;
+  uint64_t cycle = 0;
+  std::optional<std::string> failure;
+  auto expect = [&](uint16_t actual, uint16_t expected, const char* what) {
+    if (actual != expected && !failure.has_value()) {
+      failure = std::format("{} is {:#x}, expected {:#x}", what, actual,
+                            expected);
+    }
+  };
+  auto report = [&](const char* name) {
+    std::cout << "  " << std::left << std::setw(30) << name << ": ";
+    if (failure.has_value()) {
+      allMatch = false;
+      std::cerr << *failure << std::endl;
+    } else {
+      std::cout << "banks and registers match" << std::endl;
+    }
+    failure.reset();
+  };
+
+  auto romBank = [&](const gb::Cartridge& cartridge) {
+    const uint16_t bank = cartridge.read(0x4000).decay() |
+                          (cartridge.read(0x4001).decay() << 8U);
+    const uint8_t* page = pages.rom[0x40];
+    expect(page == nullptr ? 0xFFFF : page[0] | (page[1] << 8U), bank,
+           "paged ROM bank");
+    return bank;
+  };
+  auto testRamBanks = [&](gb::Cartridge& cartridge) {
+    cartridge.write(0x0000, 0x0A_B);  // Enable
+    for (uint8_t bank = 0; bank < 4; bank++) {
+      cartridge.write(0x4000, gb::Byte{bank});
+      cartridge.write(0xA123, gb::Byte{(uint8_t)(0x10U + bank)});
+    }
+    for (uint8_t bank = 0; bank < 4; bank++) {
+      cartridge.write(0x4000, gb::Byte{bank});
+      expect(cartridge.read(0xA123).decay(), 0x10U + bank, "RAM bank byte");
+      expect(pages.ram[0xA1] == nullptr ? 0 : pages.ram[0xA1][0x23].decay(),
+             0x10U + bank, "paged RAM bank byte");
+    }
+    cartridge.write(0x0000, 0x00_B);  // Disable
+    expect(cartridge.read(0xA123).decay(), 0xFF, "disabled RAM");
+  };
+
+  {
+    // MBC3+TIMER+RAM+BATTERY with 64 banks, the 7-bit bank number wraps
+    auto cartridge = gb::Cartridge::loadFromBytes(syntheticROM(0x10, 64));
+    cartridge.attach(pages, cycle, errors);
+    expect(romBank(cartridge), 1, "initial ROM bank");
+    cartridge.write(0x2000, 0x00_B);
+    expect(romBank(cartridge), 1, "ROM bank 0");
+    cartridge.write(0x2000, 0x25_B);
+    expect(romBank(cartridge), 0x25, "ROM bank 0x25");
+    cartridge.write(0x2000, 0x47_B);
+    expect(romBank(cartridge), 0x07, "wrapped ROM bank 0x47");
+    testRamBanks(cartridge);
+
+    auto latch = [&] {
+      cartridge.write(0x6000, 0x00_B);
+      cartridge.write(0x6000, 0x01_B);
+    };
+    auto clockRegister = [&](uint8_t index) {
+      cartridge.write(0x4000, gb::Byte{index});
+      return cartridge.read(0xA000).decay();
+    };
+    auto setClockRegister = [&](uint8_t index, uint8_t value) {
+      cartridge.write(0x4000, gb::Byte{index});
+      cartridge.write(0xA000, gb::Byte{value});
+    };
+    cartridge.write(0x0000, 0x0A_B);
+
+    cycle += 5 * gb::CYCLES_PER_SECOND;
+    expect(clockRegister(0x08), 0, "seconds before latching");
+    latch();
+    expect(clockRegister(0x08), 5, "latched seconds");
+    cycle += 3 * gb::CYCLES_PER_SECOND;
+    cartridge.write(0x6000, 0x01_B);  // 1 -> 1 doesn't latch
+    expect(clockRegister(0x08), 5, "seconds after writing 1 twice");
+    latch();
+    expect(clockRegister(0x08), 8, "seconds after latching again");
+
+    setClockRegister(0x0C, 0x40);  // Halt
+    cycle += 10 * gb::CYCLES_PER_SECOND;
+    latch();
+    expect(clockRegister(0x08), 8, "seconds while halted");
+    setClockRegister(0x0C, 0x00);
+    cycle += 2 * gb::CYCLES_PER_SECOND;
+    latch();
+    expect(clockRegister(0x08), 10, "seconds after resuming");
+
+    // Day 511, 23:59:59 rolls over to day 0 and sets the carry
+    setClockRegister(0x0B, 0xFF);
+    setClockRegister(0x0C, 0x01);
+    setClockRegister(0x0A, 23);
+    setClockRegister(0x09, 59);
+    setClockRegister(0x08, 59);
+    cycle += gb::CYCLES_PER_SECOND;
+    latch();
+    expect(clockRegister(0x08), 0, "seconds after day 511");
+    expect(clockRegister(0x09), 0, "minutes after day 511");
+    expect(clockRegister(0x0A), 0, "hours after day 511");
+    expect(clockRegister(0x0B), 0, "low days after day 511");
+    expect(clockRegister(0x0C), 0x80, "high days after day 511");
+    report("mbc3");
+  }
+
+  {
+    // MBC5+RAM+BATTERY with 0x140 banks, the 9-bit bank number wraps
+    auto cartridge = gb::Cartridge::loadFromBytes(syntheticROM(0x1B, 0x140));
+    cartridge.attach(pages, cycle, errors);
+    expect(romBank(cartridge), 1, "initial ROM bank");
+    cartridge.write(0x2000, 0x00_B);
+    expect(romBank(cartridge), 0, "ROM bank 0");
+    cartridge.write(0x2000, 0x34_B);
+    cartridge.write(0x3000, 0x01_B);
+    expect(romBank(cartridge), 0x134, "ROM bank 0x134");
+    cartridge.write(0x3000, 0x00_B);
+    expect(romBank(cartridge), 0x34, "ROM bank 0x34");
+    cartridge.write(0x2000, 0xFF_B);
+    cartridge.write(0x3000, 0x01_B);
+    expect(romBank(cartridge), 0x1FF % 0x140, "wrapped ROM bank 0x1FF");
+    testRamBanks(cartridge);
+    report("mbc5");
+  }
+
+  std::cout << std::endl;
+  return allMatch;
+}
+
+bool persistsBatteryRam() {
+  /*
+  Writes to a banked RAM byte of synthetic ROMs loaded with a save path, then
+  loads them again. Battery backed carts must bring the byte back and keep a
+  save file the size of their RAM, other carts must not create one. Save
+  files are mapped without the sanitizer and written back by flush() with
+  it, so both builds run this.
+  Returns true if every cart persists (or doesn't) as expected.
+  */
+  using gb::operator""_B;
+  std::cout << "Checking battery backed RAM..." << std::endl;
+
+  const auto directory =
+      std::filesystem::temp_directory_path() / "gb_save_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  const auto romPath = (directory / "cart.gb").string();
+  const auto savePath = gb::Cartridge::savePathFor(romPath);
+
+  // Selects RAM bank 2 on MBC1 (in RAM banking mode), MBC3 and MBC5
+  auto selectRamBank = [](gb::Cartridge& cartridge) {
+    cartridge.write(0x0000, 0x0A_B);
+    cartridge.write(0x6000, 0x01_B);
+    cartridge.write(0x4000, 0x02_B);
+  };
+
+  bool allMatch = true;
+  for (const auto& [type, hasBattery] :
+       {std::pair{0x03, true}, std::pair{0x13, true}, std::pair{0x1B, true},
+        std::pair{0x02, false}, std::pair{0x12, false},
+        std::pair{0x1A, false}}) {
+    const auto rom = syntheticROM((uint8_t)type, 4);
+    std::ofstream(romPath, std::ios::binary | std::ios::trunc)
+        .write((const char*)rom.data(), (std::streamsize)rom.size());
+    std::filesystem::remove(savePath);
+
+    {
+      auto cartridge = gb::Cartridge::loadFromRom(romPath, savePath);
+      selectRamBank(cartridge);
+      cartridge.write(0xA456, 0x5A_B);
+    }
+    uint8_t value = 0;
+    {
+      auto cartridge = gb::Cartridge::loadFromRom(romPath, savePath);
+      selectRamBank(cartridge);
+      value = cartridge.read(0xA456).decay_or(0);
+    }
+
+    std::optional<std::string> mismatch;
+    const bool isSaved = std::filesystem::exists(savePath);
+    if (isSaved != hasBattery) {
+      mismatch = isSaved ? "created a save file" : "didn't create a save file";
+    } else if (hasBattery && std::filesystem::file_size(savePath) !=
+                                 gb::Controller::ramSizeFromHeader(rom)) {
+      mismatch = std::format("save file is {} bytes, expected {}",
+                             std::filesystem::file_size(savePath),
+                             gb::Controller::ramSizeFromHeader(rom));
+    } else if (hasBattery && value != 0x5A) {
+      mismatch = std::format("RAM byte is {:#04x} after reloading", value);
+    }
+
+    std::cout << "  " << std::left << std::setw(30)
+              << std::format("type {:#04x}", type) << ": ";
+    if (mismatch.has_value()) {
+      allMatch = false;
+      std::cerr << *mismatch << std::endl;
+    } else {
+      std::cout << (hasBattery ? "RAM restored" : "not saved") << std::endl;
+    }
+  }
+  std::filesystem::remove_all(directory);
+  std::cout << std::endl;
+  return allMatch;
+}
+
 void runBenchmarkHeadless(const char* rom, uint64_t updates) {
   /*
   Loads a rom and times its emulation for a given number of updates.
@@ -141,6 +843,49 @@ void runBenchmarkHeadless(const char* rom, uint64_t updates) {
             << std::endl;
 }
 
+void runFetchBenchmark(const char* rom, uint64_t fetches) {
+  /*
+  Times the individual cartridge access paths. A CPU fetch normally goes
+  through the memory map's page table, the controller is only dispatched to
+  for bank switches and unmapped addresses.
+  */
+  using namespace std::chrono;
+
+  std::stringstream serialOut;
+  gb::GB gb(rom, std::make_unique<gb::Headless>(serialOut));
+
+  // Printed with the results so the reads can't be optimized away
+  uint32_t checksum = 0;
+  auto time_per_access = [&](auto&& access) {
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    for (uint64_t i = 0; i < fetches; i++) {
+      checksum += access((uint16_t)((i * 0x101U) & 0x7FFFU));
+    }
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+
+    duration<double, std::nano> time = end - start;
+    return time.count() / (double)fetches;
+  };
+
+  const double pageTableTime = time_per_access([&](uint16_t addr) {
+    return gb.memory_map.read(addr).decay_or(0);
+  });
+  const double controllerTime = time_per_access([&](uint16_t addr) {
+    return gb.cartridge.read(addr).decay_or(0);
+  });
+  const double bankSwitchTime = time_per_access([&](uint16_t addr) {
+    gb.cartridge.write(0x2000, gb::Byte{(uint8_t)((addr & 0x1U) + 1U)});
+    return 0U;
+  });
+
+  std::cout << "ROM fetch (page table): " << pageTableTime << "ns" << std::endl;
+  std::cout << "ROM fetch (controller): " << controllerTime << "ns"
+            << std::endl;
+  std::cout << "Bank switch (controller): " << bankSwitchTime << "ns"
+            << std::endl;
+  std::cout << "Checksum: " << checksum << std::endl;
+}
+
 // void runGame(const char* rom) {
 //   /*
 //   Creates a graphical output and emulates the chosen ROM at 60Hz.
@@ -160,18 +905,49 @@ int main(int argc, char* argv[]) {
   gb::permit_error_kind(gb::ErrorKind::call_frame_violation);
   gb::permit_error_kind(gb::ErrorKind::clobbered_return_address);
   gb::permit_error_kind(gb::ErrorKind::reading_return_address);
+  // The test ROMs run their tests from work RAM
+  gb::permit_error_kind(gb::ErrorKind::pc_outside_of_program_memory);
   switch (argc) {
-    case 1:
-      // Test mode
-      if (!passesAllTests())
+    case 1: {
+      // Test mode, every suite runs even if an earlier one failed
+      bool passed = passesAllTests();
+      passed = skipsOnlyUnchangedFrames() && passed;
+      passed = restoresSaveStates() && passed;
+      passed = restoresRewoundStates() && passed;
+      passed = capturesFrames() && passed;
+      passed = switchesCartridgeBanks() && passed;
+      passed = persistsBatteryRam() && passed;
+      passed = matchesGoldenFrames() && passed;
+      if (!passed)
         return EXIT_FAILURE;
       break;
+    }
+    case 2:
+      // Golden frames only: --golden or --update-goldens
+      if (std::string_view{argv[1]} == "--golden") {
+        return matchesGoldenFrames() ? EXIT_SUCCESS : EXIT_FAILURE;
+      }
+      if (std::string_view{argv[1]} == "--update-goldens") {
+        return updateGoldenFrames() ? EXIT_SUCCESS : EXIT_FAILURE;
+      }
+      std::cerr << "Unknown test mode " << argv[1] << std::endl;
+      return EXIT_FAILURE;
     case 3:
       // Benchmarking mode
       runBenchmarkHeadless(argv[1], atoll(argv[2]));
       break;
+    case 4:
+      // Cartridge access micro-benchmark: --fetch <rom> <fetches>
+      if (std::string_view{argv[1]} != "--fetch") {
+        std::cerr << "Unknown benchmark " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+      }
+      runFetchBenchmark(argv[2], atoll(argv[3]));
+      break;
     default:
-      std::cerr << "Program requires 0 or 2 argument" << std::endl;
+      std::cerr << "Usage: tests.out [--golden | --update-goldens]" << std::endl
+                << "       tests.out <rom> <updates>" << std::endl
+                << "       tests.out --fetch <rom> <fetches>" << std::endl;
       break;
   }
   return EXIT_SUCCESS;
@@ -15,9 +15,7 @@ auto main(int argc, char** argv) -> int {
   auto gb =
       gb::load_from_elf(std::make_unique<gb::Headless>(std::cout), elf_path);
 
-  try {
-    gb::run_standalone(*gb);
-  } catch (const gb::Trap&) {
+  if (gb::run_standalone(*gb) == gb::StopReason::trap) {
     std::cout << "done" << std::endl;
   }
 }